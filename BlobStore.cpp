@@ -0,0 +1,408 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "BlobStore.hpp"
+#include "Constants.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QtEndian>
+
+// C++ standard library includes -----------------------------------------------
+#include <cstring>
+
+namespace
+{
+constexpr const auto   vacuumMaxGenerations = 16;
+constexpr const qint64 vacuumMinGarbageSize = 16 * 1024 * 1024;
+
+// Small bodies are not worth the cost of a decompression, and fast compression
+// already divides the size of text bodies by several times
+constexpr const auto   compressionMinSize   = 512;
+constexpr const auto   compressionLevel     = 1;
+
+// Larger bodies are stored as they are, their compression would need to hold
+// them in memory
+constexpr const auto   compressionMaxSize   = 64 * 1024 * 1024;
+
+// xxHash64 with a seed of 0
+constexpr const quint64 prime1 = 11400714785074694791ULL;
+constexpr const quint64 prime2 = 14029467366897019727ULL;
+constexpr const quint64 prime3 =  1609587929392839161ULL;
+constexpr const quint64 prime4 =  9650029242287828579ULL;
+constexpr const quint64 prime5 =  2870177450012600261ULL;
+
+quint64 rotl(quint64 value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+quint64 read64(const uchar * p)       { quint64 value; std::memcpy(&value, p, 8); return qFromLittleEndian(value); }
+quint32 read32(const uchar * p)       { quint32 value; std::memcpy(&value, p, 4); return qFromLittleEndian(value); }
+
+quint64 xxRound(quint64 accumulator, quint64 input)
+{
+    accumulator += input * prime2;
+    return rotl(accumulator, 31) * prime1;
+}
+
+quint64 mergeRound(quint64 accumulator, quint64 value)
+{
+    accumulator ^= xxRound(0, value);
+    return accumulator * prime1 + prime4;
+}
+
+quint64 xxHash64(const char * data, int size)
+{
+    auto       p   = reinterpret_cast<const uchar *>(data);
+    const auto end = p + size;
+    quint64    hash;
+
+    if (size >= 32)
+    {
+        quint64 v1 = prime1 + prime2;
+        quint64 v2 = prime2;
+        quint64 v3 = 0;
+        quint64 v4 = 0 - prime1;
+        do
+        {
+            v1 = xxRound(v1, read64(p)); p += 8;
+            v2 = xxRound(v2, read64(p)); p += 8;
+            v3 = xxRound(v3, read64(p)); p += 8;
+            v4 = xxRound(v4, read64(p)); p += 8;
+        } while (p + 32 <= end);
+
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else
+        hash = prime5;
+
+    hash += static_cast<quint64>(size);
+    for (; p + 8 <= end; p += 8)
+        hash = rotl(hash ^ xxRound(0, read64(p)), 27) * prime1 + prime4;
+    if (p + 4 <= end)
+    {
+        hash = rotl(hash ^ (read32(p) * prime1), 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+        hash = rotl(hash ^ (*p * prime5), 11) * prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+QMap<quint32, QString> listFiles(const QString & basePath)
+{
+    const QFileInfo info(basePath);
+    const auto prefix = info.fileName() + ".bodies.";
+
+    QMap<quint32, QString> files;
+    const auto fileInfoList = info.dir().entryInfoList({prefix + "*"}, QDir::Files);
+    for (const auto & fileInfo : fileInfoList)
+    {
+        bool ok = false;
+        const auto generation = fileInfo.fileName().mid(prefix.size()).toUInt(&ok);
+        if (ok && generation != 0)
+            files.insert(generation, fileInfo.absoluteFilePath());
+    }
+
+    return files;
+}
+} // !namespace
+
+void BlobStore::open(const QString & basePath)
+{
+    close();
+    _basePath       = basePath;
+    _existingFiles  = listFiles(basePath);
+    _nextGeneration = _existingFiles.isEmpty() ? 1 : _existingFiles.lastKey() + 1;
+    _cache          = std::make_shared<BodyCache>(Constants::bodyCacheSize);
+}
+
+void BlobStore::close()
+{
+    // The files stay open as long as a body references them
+    _existingFiles.clear();
+    _files.clear();
+    _activeFile.reset();
+    _cache.reset();
+
+    _index.clear();
+    _references.clear();
+    _statistics = Statistics();
+}
+
+void BlobStore::attach(Body & body)
+{
+    if (!body.isStored())
+        return ;
+
+    const auto file = _file(body.generation());
+    body.attach(file);
+
+    // Bodies stored before the content was hashed cannot be shared
+    if (file != nullptr && body.hash() != 0)
+        _index.insert(qMakePair(body.hash(), body.size()), body.location());
+}
+
+bool BlobStore::store(Body & body)
+{
+    if (body.isStored() || body.isEmpty())
+        return true;
+
+    if (!body.fitsInArray())
+        return _storeLarge(body);
+
+    const auto data = body.data();
+    const auto key  = qMakePair(hash(data), data.size());
+
+    // The content is compared as well so a hash collision cannot mix bodies up
+    const auto itr = _index.constFind(key);
+    if (itr != _index.constEnd())
+    {
+        Body existing;
+        existing.setLocation(itr.value(), data.size(), key.first);
+        existing.attach(_files.value(itr->generation));
+        if (existing.data() == data)
+        {
+            body = existing;
+            return true;
+        }
+    }
+
+    if (!_openActiveFile())
+        return false;
+
+    Body::Location location;
+    auto stored = data;
+    if (_compression && data.size() >= compressionMinSize && data.size() <= compressionMaxSize)
+    {
+        // Only kept when it saves at least an eighth of the body
+        const auto compressed = qCompress(data, compressionLevel);
+        if (compressed.size() <= data.size() - data.size() / 8)
+        {
+            stored         = compressed;
+            location.codec = Body::Codec::Zlib;
+        }
+    }
+
+    location.generation = _activeFile->generation();
+    location.offset     = _activeFile->append(stored);
+    location.size       = stored.size();
+    if (location.offset < 0)
+        return false;
+
+    body.setLocation(location, data.size(), key.first);
+    body.attach(_activeFile);
+    if (body.isCompressed())
+        body.evict();
+    if (!_index.contains(key))
+        _index.insert(key, location);
+    return true;
+}
+
+void BlobStore::removeUnusedFiles()
+{
+    // Files left by a vacuum or only holding bodies of removed requests
+    for (auto itr = _existingFiles.begin(); itr != _existingFiles.end(); ++itr)
+        if (!_files.contains(itr.key()))
+            QFile::remove(itr.value());
+
+    _existingFiles.clear();
+}
+
+void BlobStore::acquire(const Reference & reference)
+{
+    if (reference.generation == 0)
+        return ;
+
+    auto & count = _references[qMakePair(reference.generation, reference.offset)];
+    if (count++ == 0)
+    {
+        _statistics.uniqueSize += reference.size;
+        _statistics.storedSize += reference.storedSize;
+        ++_statistics.blobs;
+    }
+
+    _statistics.referencedSize += reference.size;
+    ++_statistics.references;
+}
+
+void BlobStore::release(const Reference & reference)
+{
+    const auto itr = _references.find(qMakePair(reference.generation, reference.offset));
+    if (itr == _references.end())
+        return ;
+
+    _statistics.referencedSize -= reference.size;
+    --_statistics.references;
+
+    if (--itr.value() == 0)
+    {
+        _references.erase(itr);
+        _statistics.uniqueSize -= reference.size;
+        _statistics.storedSize -= reference.storedSize;
+        --_statistics.blobs;
+    }
+}
+
+BlobStore::Reference BlobStore::reference(const Body & body)
+{
+    Reference reference;
+    if (body.isStored())
+    {
+        reference.generation = body.generation();
+        reference.offset     = body.offset();
+        reference.size       = body.size();
+        reference.storedSize = body.storedSize();
+    }
+
+    return reference;
+}
+
+quint64 BlobStore::hash(const QByteArray & data)
+{
+    return xxHash64(data.constData(), data.size());
+}
+
+QString BlobStore::filename(const QString & basePath, quint32 generation)
+{
+    return QString("%1.bodies.%2").arg(basePath).arg(generation);
+}
+
+bool BlobStore::vacuum(const QString & basePath, const QVector<Body *> & bodies, quint32 generation)
+{
+    // Nothing is done as long as most of the files content is alive
+    QMap<quint32, qint64> liveSizes;
+    QSet<Location>        locations;
+    for (const auto & body : bodies)
+    {
+        const auto location = qMakePair(body->generation(), body->offset());
+        if (!body->isStored() || locations.contains(location))
+            continue;
+
+        locations.insert(location);
+        liveSizes[body->generation()] += body->storedSize();
+    }
+
+    qint64 liveSize  = 0;
+    qint64 totalSize = 0;
+    for (auto itr = liveSizes.begin(); itr != liveSizes.end(); ++itr)
+    {
+        liveSize  += itr.value();
+        totalSize += QFileInfo(filename(basePath, itr.key())).size();
+    }
+
+    const auto garbageSize = totalSize - liveSize;
+    if (liveSizes.size() < vacuumMaxGenerations &&
+        (garbageSize < vacuumMinGarbageSize || garbageSize < liveSize))
+        return true;
+
+    // The live bodies are copied into a new generation, the previous ones are
+    // removed on the next start once nothing references them anymore
+    BodyFile target(filename(basePath, generation), generation);
+    if (!target.open(true))
+        return false;
+
+    QMap<quint32, BodyFilePtr> sources;
+    for (auto itr = liveSizes.begin(); itr != liveSizes.end(); ++itr)
+    {
+        auto source = std::make_shared<BodyFile>(filename(basePath, itr.key()), itr.key());
+        if (source->open(false))
+            sources.insert(itr.key(), source);
+    }
+
+    QHash<Location, qint64> offsets;
+    for (const auto & body : bodies)
+    {
+        const auto source = sources.value(body->generation());
+        if (!body->isStored() || source == nullptr)
+            continue;
+
+        // The bodies are copied as they are stored, compressed or not
+        auto location = body->location();
+        const auto key = qMakePair(location.generation, location.offset);
+        auto offset = offsets.value(key, -1);
+        if (offset < 0)
+        {
+            offset = target.append(*source, location.offset, location.size);
+            if (offset < 0)
+                return false;
+            offsets.insert(key, offset);
+        }
+
+        location.generation = generation;
+        location.offset     = offset;
+        body->setLocation(location, body->size(), body->hash());
+    }
+
+    return true;
+}
+
+bool BlobStore::_storeLarge(Body & body)
+{
+    // Only spilled bodies are larger than a QByteArray, they are copied by
+    // chunks from their temporary file as they are: neither compressed, since
+    // qCompress() needs the whole body, nor hashed and shared
+    const auto source = body.file();
+    if (source == nullptr || !_openActiveFile())
+        return false;
+
+    Body::Location location;
+    location.generation = _activeFile->generation();
+    location.offset     = _activeFile->append(*source, body.offset(), body.size());
+    location.size       = body.size();
+    if (location.offset < 0)
+        return false;
+
+    body.setLocation(location, body.size(), 0);
+    body.attach(_activeFile);
+    return true;
+}
+
+bool BlobStore::_openActiveFile()
+{
+    if (_activeFile != nullptr)
+        return true;
+
+    _activeFile = _openFile(allocateGeneration(), true);
+    if (_activeFile == nullptr)
+        return false;
+    _files.insert(_activeFile->generation(), _activeFile);
+    return true;
+}
+
+BodyFilePtr BlobStore::_file(quint32 generation)
+{
+    const auto itr = _files.constFind(generation);
+    if (itr != _files.constEnd())
+        return itr.value();
+
+    // A missing file is only reported once
+    const auto file = _openFile(generation, false);
+    _files.insert(generation, file);
+    return file;
+}
+
+BodyFilePtr BlobStore::_openFile(quint32 generation, bool writable)
+{
+    auto file = std::make_shared<BodyFile>(filename(_basePath, generation), generation);
+    if (!file->open(writable))
+        return nullptr;
+
+    file->setCache(_cache);
+    return file;
+}
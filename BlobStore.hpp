@@ -0,0 +1,96 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+
+// Project includes ------------------------------------------------------------
+#include "Body.hpp"
+
+// Content-addressed storage of the history bodies.
+//
+// Bodies are indexed by a hash of their content so a body identical to one
+// already stored is not written again: it references the stored copy, which
+// is shared on disk and, since it is memory mapped, in memory. The number of
+// references of each stored body is tracked to report the savings.
+//
+// Unless disabled, a body is compressed before being written when it saves a
+// significant amount of space. Compressed bodies are decompressed on demand and
+// the most recently used ones are kept in a cache shared by all the files.
+class BlobStore
+{
+public:
+    using Location = QPair<quint32, qint64>;
+
+    struct Reference
+    {
+        quint32 generation = 0;
+        qint64  offset     = -1;
+        qint64  size       = 0;
+        qint64  storedSize = 0;
+    };
+
+    struct Statistics
+    {
+        qint64 referencedSize = 0;
+        qint64 uniqueSize     = 0;
+        qint64 storedSize     = 0;
+        int    references     = 0;
+        int    blobs          = 0;
+    };
+
+public:
+    void open(const QString & basePath);
+    void close();
+
+    bool isCompressionEnabled() const      { return _compression; }
+    void setCompressionEnabled(bool value) { _compression = value; }
+
+    quint32 allocateGeneration() { return _nextGeneration++; }
+    void seal()                  { _activeFile.reset(); }
+
+    void attach(Body & body);
+    bool store(Body & body);
+    void removeUnusedFiles();
+
+    void acquire(const Reference & reference);
+    void release(const Reference & reference);
+    const Statistics & statistics() const { return _statistics; }
+    qint64 cacheSize() const              { return _cache == nullptr ? 0 : _cache->totalCost(); }
+
+public:
+    static Reference reference(const Body & body);
+    static quint64 hash(const QByteArray & data);
+    static QString filename(const QString & basePath, quint32 generation);
+    static bool vacuum(const QString & basePath, const QVector<Body *> & bodies, quint32 generation);
+
+private:
+    bool _storeLarge(Body & body);
+    bool _openActiveFile();
+    BodyFilePtr _file(quint32 generation);
+    BodyFilePtr _openFile(quint32 generation, bool writable);
+
+private:
+    QString                    _basePath;
+    QMap<quint32, QString>     _existingFiles;
+    QMap<quint32, BodyFilePtr> _files;
+    BodyFilePtr                _activeFile;
+    quint32                    _nextGeneration = 1;
+    bool                       _compression    = true;
+    BodyCachePtr               _cache;
+
+    QHash<QPair<quint64, qint64>, Body::Location> _index;
+    QHash<Location, int>                          _references;
+    Statistics                                    _statistics;
+};
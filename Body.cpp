@@ -0,0 +1,250 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "Body.hpp"
+
+namespace
+{
+// Bodies copied from a file to another are read by chunks of that size
+constexpr const qint64 copyChunkSize = 4 * 1024 * 1024;
+} // !namespace
+
+// Defined as well since qMin() takes it by reference
+constexpr const qint64 Body::maxArraySize;
+
+BodyFile::BodyFile(const QString & filename, quint32 generation) :
+    _file(filename),
+    _generation(generation),
+    _map(nullptr),
+    _mapSize(0),
+    _autoRemove(false)
+{}
+
+BodyFile::~BodyFile()
+{
+    // Unmapped by QFile when it is closed
+    _file.close();
+    if (_autoRemove)
+        _file.remove();
+}
+
+bool BodyFile::open(bool writable)
+{
+    if (!_file.open(writable ? QIODevice::ReadWrite : QIODevice::ReadOnly))
+    {
+        qWarning("Unable to open file '%s': %s", qPrintable(_file.fileName()), qPrintable(_file.errorString()));
+        return false;
+    }
+
+    // Everything already written is mapped at once, the bodies appended later
+    // are mapped one by one when they are read
+    _mapSize = _file.size();
+    if (_mapSize > 0)
+        _map = _file.map(0, _mapSize);
+    if (_map == nullptr)
+        _mapSize = 0;
+
+    return true;
+}
+
+qint64 BodyFile::append(const QByteArray & data)
+{
+    QMutexLocker lock(&_mutex);
+    const auto offset = _file.size();
+    if (!_file.seek(offset) || _file.write(data) != data.size() || !_file.flush())
+    {
+        qWarning("Unable to write into file '%s': %s", qPrintable(_file.fileName()), qPrintable(_file.errorString()));
+        _file.resize(offset);
+        return -1;
+    }
+
+    return offset;
+}
+
+qint64 BodyFile::append(const BodyFile & source, qint64 offset, qint64 size)
+{
+    QMutexLocker lock(&_mutex);
+    const auto start = _file.size();
+    auto ok = _file.seek(start);
+
+    // Copied by chunks, the bytes may not fit in a QByteArray
+    for (qint64 position = 0; ok && position < size; position += copyChunkSize)
+    {
+        const auto chunkSize = static_cast<int>(qMin(copyChunkSize, size - position));
+        const auto chunk     = source._copy(offset + position, chunkSize);
+        ok = chunk.size() == chunkSize && _file.write(chunk) == chunkSize;
+    }
+
+    if (!ok || !_file.flush())
+    {
+        qWarning("Unable to write into file '%s': %s", qPrintable(_file.fileName()), qPrintable(_file.errorString()));
+        _file.resize(start);
+        return -1;
+    }
+
+    return start;
+}
+
+QByteArray BodyFile::read(qint64 offset, int size) const
+{
+    if (size <= 0 || offset < 0)
+        return {};
+
+    const uchar * data = nullptr;
+    if (offset + size <= _mapSize)
+        data = _map + offset;
+    else
+    {
+        QMutexLocker lock(&_mutex);
+        const auto key = qMakePair(offset, static_cast<qint64>(size));
+        auto region = _regions.value(key, nullptr);
+        if (region == nullptr)
+        {
+            region = _file.map(offset, size);
+            if (region == nullptr)
+            {
+                // Fallback on a plain read if the region cannot be mapped
+                _file.seek(offset);
+                return _file.read(size);
+            }
+            _regions.insert(key, region);
+        }
+        data = region;
+    }
+
+    // The mappings are kept until the file is closed so the returned array can
+    // safely reference them
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(data), size);
+}
+
+QByteArray BodyFile::_copy(qint64 offset, int size) const
+{
+    // Unlike read(), no region is mapped and kept for bytes only copied once
+    if (offset + size <= _mapSize)
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(_map + offset), size);
+
+    QMutexLocker lock(&_mutex);
+    if (!_file.seek(offset))
+        return {};
+    return _file.read(size);
+}
+
+Body::Body(const QByteArray & data) :
+    _data(data),
+    _size(data.size())
+{}
+
+QByteArray Body::data() const
+{
+    if (!_data.isNull() || _file == nullptr || !isCompressed())
+        return uncachedData();
+
+    const auto cache = _file->cache();
+    const auto key   = qMakePair(_location.generation, _location.offset);
+    if (cache != nullptr)
+    {
+        const auto cached = cache->object(key);
+        if (cached != nullptr)
+            return *cached;
+    }
+
+    const auto data = uncachedData();
+    if (cache != nullptr && data.size() == _size)
+        cache->insert(key, new QByteArray(data), data.size());
+    return data;
+}
+
+QByteArray Body::uncachedData() const
+{
+    if (!_data.isNull() || _file == nullptr)
+        return _data;
+
+    if (!fitsInArray())
+    {
+        qWarning("The body at offset %lld in '%s' is too large to be read at once", _location.offset,
+                 qPrintable(_file->fileName()));
+        return {};
+    }
+
+    const auto stored = _file->read(_location.offset, static_cast<int>(_location.size));
+    if (_location.codec == Codec::Raw)
+        return stored;
+
+    const auto data = qUncompress(stored);
+    if (data.size() != _size)
+    {
+        qWarning("Unable to decompress the body at offset %lld in '%s'", _location.offset,
+                 qPrintable(_file->fileName()));
+        return {};
+    }
+
+    return data;
+}
+
+QByteArray Body::read(qint64 offset, int size) const
+{
+    size = static_cast<int>(qMin<qint64>(size, _size - offset));
+    if (offset < 0 || size <= 0)
+        return {};
+
+    // The bytes held in memory are referenced, they live as long as the body
+    if (!_data.isNull())
+        return QByteArray::fromRawData(_data.constData() + offset, size);
+    if (_file == nullptr)
+        return {};
+    if (_location.codec == Codec::Raw)
+        return _file->read(_location.offset + offset, size);
+
+    // Compressed bodies always fit in a QByteArray
+    return data().mid(static_cast<int>(offset), size);
+}
+
+void Body::setLocation(const Location & location, qint64 size, quint64 hash)
+{
+    _location = location;
+    _size     = size;
+    _hash     = hash;
+}
+
+void Body::attach(BodyFilePtr file)
+{
+    _file = std::move(file);
+}
+
+void Body::evict()
+{
+    // Only possible once the body can be read back from its file
+    if (_file != nullptr)
+        _data = QByteArray();
+}
+
+BodyReader::BodyReader(const Body & body) :
+    _body(body)
+{}
+
+QByteArray BodyReader::read(qint64 offset, int size)
+{
+    size = static_cast<int>(qMin<qint64>(size, _body.size() - offset));
+    if (offset < 0 || size <= 0)
+        return {};
+    if (size > pageSize)
+        return _body.read(offset, size);
+
+    // A page spans two page sizes so bytes starting anywhere in its first half
+    // are always in it, and the pages read again are the same windows
+    if (offset < _pageOffset || offset + size > _pageOffset + _page.size())
+    {
+        _pageOffset = offset - offset % pageSize;
+        _page       = _body.read(_pageOffset, 2 * pageSize);
+        if (offset + size > _pageOffset + _page.size())
+            return {};
+    }
+
+    return QByteArray::fromRawData(_page.constData() + (offset - _pageOffset), size);
+}
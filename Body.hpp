@@ -0,0 +1,158 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QByteArray>
+#include <QCache>
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+
+// C++ standard library includes -----------------------------------------------
+#include <limits>
+#include <memory>
+
+// Bodies recently decompressed, keyed by generation and offset. A cache is
+// shared by all the files of a store.
+using BodyCache    = QCache<QPair<quint32, qint64>, QByteArray>;
+using BodyCachePtr = std::shared_ptr<BodyCache>;
+
+// Append-only file holding the request and response bodies of the history.
+//
+// The files are numbered by generation: a generation is only appended to until
+// the next journal compaction, after which it is never modified again. Bodies
+// are read through a memory mapping of the file so loading one does not copy
+// it nor requires it to be kept in memory.
+class BodyFile
+{
+public:
+    BodyFile(const QString & filename, quint32 generation);
+    ~BodyFile();
+
+    bool open(bool writable);
+
+    quint32 generation() const { return _generation; }
+    QString fileName() const   { return _file.fileName(); }
+    qint64 size() const        { return _file.size(); }
+
+    qint64 append(const QByteArray & data);
+    qint64 append(const BodyFile & source, qint64 offset, qint64 size);
+    QByteArray read(qint64 offset, int size) const;
+
+    BodyCache * cache() const                 { return _cache.get(); }
+    void setCache(const BodyCachePtr & cache) { _cache = cache; }
+
+    // Removes the file once closed, for the temporary files
+    void setAutoRemove(bool value)            { _autoRemove = value; }
+
+private:
+    QByteArray _copy(qint64 offset, int size) const;
+
+private:
+    mutable QFile                                _file;
+    mutable QMutex                               _mutex;   // Guards the file and the regions, also read by workers
+    quint32                                      _generation;
+    uchar                                      * _map;
+    qint64                                       _mapSize;
+    mutable QMap<QPair<qint64, qint64>, uchar *> _regions;
+    BodyCachePtr                                 _cache;
+    bool                                         _autoRemove;
+};
+
+using BodyFilePtr = std::shared_ptr<BodyFile>;
+
+// Request or response body which is either held in memory or stored in a
+// BodyFile, in which case it is only read when data() is called. A stored body
+// may be compressed in its file, it is then decompressed by data() and kept in
+// the cache of the file so displaying it again is immediate.
+//
+// A body spilled by a BodyBuffer may be larger than a QByteArray: data() cannot
+// return it and it is only read by windows, with read() or a BodyReader.
+class Body
+{
+public:
+    static constexpr const qint64 maxArraySize = std::numeric_limits<int>::max();
+
+    enum class Codec : quint8
+    {
+        Raw  = 0,
+        Zlib = 1
+    };
+
+    // Where and how the body is written in its file
+    struct Location
+    {
+        quint32 generation = 0;
+        qint64  offset     = -1;
+        qint64  size       = 0;
+        Codec   codec      = Codec::Raw;
+    };
+
+public:
+    Body() = default;
+    Body(const QByteArray & data);
+
+    QByteArray data() const;
+    // Does not use the cache of the file, so a worker can read the body
+    QByteArray uncachedData() const;
+    QByteArray read(qint64 offset, int size) const;
+    qint64 size() const       { return _size; }
+    bool isEmpty() const      { return _size == 0; }
+    bool fitsInArray() const  { return _size <= maxArraySize; }
+
+    bool isResident() const             { return !_data.isNull(); }
+    bool isStored() const               { return _location.generation != 0; }
+    bool isCompressed() const           { return _location.codec != Codec::Raw; }
+    const Location & location() const   { return _location; }
+    quint32 generation() const          { return _location.generation; }
+    qint64 offset() const               { return _location.offset; }
+    qint64 storedSize() const           { return _location.size; }
+    quint64 hash() const                { return _hash; }
+    const BodyFilePtr & file() const    { return _file; }
+
+    void setLocation(const Location & location, qint64 size, quint64 hash);
+    void attach(BodyFilePtr file);
+    void evict();
+
+private:
+    QByteArray  _data;
+    qint64      _size = 0;
+    quint64     _hash = 0;
+    Location    _location;
+    BodyFilePtr _file;
+};
+
+// Random access to a body by pages, for the views.
+//
+// The page holding the bytes read is kept so reading the following ones is
+// immediate. The pages of a stored body are windows of its memory mapping, so a
+// body larger than a QByteArray is read as easily as any other.
+class BodyReader
+{
+public:
+    static constexpr const int pageSize = 4 * 1024 * 1024;
+
+public:
+    BodyReader() = default;
+    explicit BodyReader(const Body & body);
+
+    const Body & body() const { return _body; }
+    qint64 size() const       { return _body.size(); }
+
+    // The bytes returned are only valid until the next read
+    QByteArray read(qint64 offset, int size);
+
+private:
+    Body       _body;
+    QByteArray _page;
+    qint64     _pageOffset = 0;
+};
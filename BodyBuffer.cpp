@@ -0,0 +1,95 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "BodyBuffer.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QDir>
+
+// A body kept in memory is a QByteArray, a larger one is always spilled
+BodyBuffer::BodyBuffer(qint64 threshold) :
+    _threshold(qMin(threshold, Body::maxArraySize)),
+    _size(0)
+{}
+
+void BodyBuffer::reserve(qint64 size)
+{
+    // Only worth it when the body is known to stay in memory
+    if (size > 0 && size <= _threshold && _file == nullptr)
+        _data.reserve(static_cast<int>(size));
+}
+
+bool BodyBuffer::append(const QByteArray & data)
+{
+    if (data.isEmpty())
+        return true;
+
+    _size += data.size();
+    if (_file == nullptr)
+    {
+        _data.append(data);
+        return _size <= _threshold || _spill();
+    }
+
+    if (_file->write(data) != data.size())
+    {
+        _errorString = _file->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+Body BodyBuffer::take()
+{
+    if (_file == nullptr)
+    {
+        const Body body(_data);
+        _data = QByteArray();
+        _size = 0;
+        return body;
+    }
+
+    // The temporary file is handed over to the body
+    const auto filename = _file->fileName();
+    _file->setAutoRemove(false);
+    _file->close();
+    _file.reset();
+
+    const auto size = _size;
+    _size = 0;
+
+    auto file = std::make_shared<BodyFile>(filename, 0);
+    file->setAutoRemove(true);
+    if (!file->open(false))
+        return {};
+
+    Body::Location location;
+    location.offset = 0;
+    location.size   = size;
+
+    Body body;
+    body.setLocation(location, size, 0);
+    body.attach(file);
+    return body;
+}
+
+bool BodyBuffer::_spill()
+{
+    _file.reset(new QTemporaryFile(QDir::temp().filePath("HttpRequester-XXXXXX.body")));
+    if (!_file->open() || _file->write(_data) != _data.size())
+    {
+        _errorString = _file->errorString();
+        _file.reset();
+        return false;
+    }
+
+    _data = QByteArray();
+    return true;
+}
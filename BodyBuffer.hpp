@@ -0,0 +1,51 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QByteArray>
+#include <QTemporaryFile>
+
+// Project includes ------------------------------------------------------------
+#include "Body.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <memory>
+
+// Growable buffer receiving a body by chunks, as they are read from the
+// network.
+//
+// The body is kept in memory until it reaches a threshold, past which it is
+// moved to a temporary file and the following chunks are appended to it. The
+// body taken from a spilled buffer reads the temporary file through a memory
+// mapping, and the file is removed once no body references it anymore.
+class BodyBuffer
+{
+public:
+    explicit BodyBuffer(qint64 threshold);
+
+    void reserve(qint64 size);
+    bool append(const QByteArray & data);
+    Body take();
+
+    qint64 size() const                 { return _size; }
+    bool isSpilled() const              { return _file != nullptr; }
+    const QString & errorString() const { return _errorString; }
+
+private:
+    bool _spill();
+
+private:
+    qint64                          _threshold;
+    qint64                          _size;
+    QByteArray                      _data;
+    std::unique_ptr<QTemporaryFile> _file;
+    QString                         _errorString;
+};
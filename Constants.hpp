@@ -19,6 +19,8 @@ namespace Keys
     constexpr const auto requestHeaders           = "headers";
     constexpr const auto requestDate              = "date";
     constexpr const auto requestElaspedTime       = "elapsed_time";
+    constexpr const auto requestTimings           = "timings";
+    constexpr const auto requestThroughput        = "throughput";
 
     constexpr const auto response                 = "response";
     constexpr const auto responseStatus           = "status_code";
@@ -26,13 +28,34 @@ namespace Keys
     constexpr const auto responseContent          = "content";
     constexpr const auto responseHeaders          = "headers";
     constexpr const auto responseDisplayFormat    = "display_format";
+    constexpr const auto responseWireSize         = "wire_size";
+    constexpr const auto responseDownload         = "download";
+    constexpr const auto downloadPath             = "path";
+    constexpr const auto downloadSize             = "size";
+    constexpr const auto downloadHash             = "sha256";
 
     constexpr const auto exportVersion            = "version";
 } // !namespace Keys
 
 namespace Constants
 {
-    constexpr const auto maxHistorySize     = 100;
+    constexpr const auto maxHistorySize     = 1000000;
+    constexpr const auto completionSize     = 1000;
+    constexpr const auto searchMaxBodySize  = 1024 * 1024;
     constexpr const auto applicationVersion = "1.8";
     constexpr const auto exportDateFormat   = "dd-MM-yyyyTHH:mm:ss.zzz";
+    constexpr const auto bodyCacheSize      = 64 * 1024 * 1024;
+    constexpr const auto historyBatchSize   = 500;
+    constexpr const auto importChunkSize    = 500;
+    constexpr const auto memoryBudget       = 256 * 1024 * 1024;
+    constexpr const auto spillThreshold     = 16 * 1024 * 1024;
+    constexpr const auto receiveChunkSize   = 1024 * 1024;
+    constexpr const auto largeTextSize      = 1024 * 1024;
+    constexpr const auto formatCacheSize    = 64 * 1024 * 1024;
+    constexpr const auto treeExpandMaxItems = 10000;
+
+    constexpr const quint32 binaryExportVersion  = 2;
+    constexpr const auto    binaryExportMimeType = "application/x-httprequester-requests";
+    constexpr const auto    binaryExportSuffix   = "hrq";
+    constexpr const auto    maxClipboardJsonSize = 4 * 1024 * 1024;
 } // !namespace Constants
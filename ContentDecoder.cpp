@@ -0,0 +1,335 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "ContentDecoder.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QList>
+
+// C++ standard library includes -----------------------------------------------
+#include <vector>
+
+// Third party includes --------------------------------------------------------
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+# include <brotli/decode.h>
+#endif
+#ifdef HAVE_ZSTD
+# include <zstd.h>
+#endif
+
+namespace
+{
+constexpr const auto outputChunkSize = 64 * 1024;
+
+// Handles gzip, and deflate which is either zlib wrapped as the specification
+// requires or raw as some servers send it
+class ZlibDecoder : public ContentDecoder
+{
+public:
+    explicit ZlibDecoder(bool gzip) :
+        _gzip(gzip),
+        _started(false),
+        _ended(false)
+    {
+        _stream = z_stream();
+        _initialized = inflateInit2(&_stream, gzip ? 15 + 16 : 15) == Z_OK;
+    }
+
+    ~ZlibDecoder() override
+    {
+        if (_initialized)
+            inflateEnd(&_stream);
+    }
+
+    bool decode(const QByteArray & input, QByteArray & output) override
+    {
+        if (!_initialized)
+        {
+            _errorString = "Unable to initialize zlib";
+            return false;
+        }
+
+        if (input.isEmpty() || _ended)
+            return true;
+
+        // A raw deflate stream is recognized by the lack of a zlib header, the
+        // data is held until its first two bytes are known
+        auto data = input;
+        if (!_started && !_gzip)
+        {
+            _head.append(input);
+            if (_head.size() < 2)
+                return true;
+
+            data = _head;
+            _head.clear();
+            const auto header = (static_cast<uchar>(data.at(0)) << 8) | static_cast<uchar>(data.at(1));
+            if (((header >> 8) & 0x0f) != Z_DEFLATED || header % 31 != 0)
+            {
+                inflateEnd(&_stream);
+                _stream = z_stream();
+                _initialized = inflateInit2(&_stream, -15) == Z_OK;
+            }
+        }
+        _started = true;
+
+        _stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+        _stream.avail_in = static_cast<uInt>(data.size());
+        char buffer[outputChunkSize];
+        do
+        {
+            _stream.next_out  = reinterpret_cast<Bytef *>(buffer);
+            _stream.avail_out = sizeof(buffer);
+            const auto result = inflate(&_stream, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+            {
+                _errorString = QString("Invalid %1 data: %2").arg(_gzip ? "gzip" : "deflate")
+                                                             .arg(_stream.msg != nullptr ? _stream.msg : "unknown error");
+                return false;
+            }
+
+            output.append(buffer, static_cast<int>(sizeof(buffer) - _stream.avail_out));
+            if (result == Z_STREAM_END)
+                _ended = true;
+            if (result != Z_OK)
+                break;
+        } while (_stream.avail_out == 0 || _stream.avail_in > 0);
+
+        return true;
+    }
+
+    bool finish(QByteArray &) override
+    {
+        if (!_ended && (_started || !_head.isEmpty()))
+        {
+            _errorString = QString("Truncated %1 data").arg(_gzip ? "gzip" : "deflate");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    z_stream   _stream;
+    QByteArray _head;
+    bool       _gzip;
+    bool       _initialized;
+    bool       _started;
+    bool       _ended;
+};
+
+#ifdef HAVE_BROTLI
+class BrotliDecoder : public ContentDecoder
+{
+public:
+    BrotliDecoder() :
+        _state(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr)),
+        _ended(false)
+    {}
+
+    ~BrotliDecoder() override
+    {
+        BrotliDecoderDestroyInstance(_state);
+    }
+
+    bool decode(const QByteArray & input, QByteArray & output) override
+    {
+        if (_ended)
+            return true;
+
+        auto   next      = reinterpret_cast<const uint8_t *>(input.constData());
+        size_t available = static_cast<size_t>(input.size());
+        uint8_t buffer[outputChunkSize];
+        for (;;)
+        {
+            auto   out       = buffer;
+            size_t outputLeft = sizeof(buffer);
+            const auto result = BrotliDecoderDecompressStream(_state, &available, &next,
+                                                              &outputLeft, &out, nullptr);
+            output.append(reinterpret_cast<const char *>(buffer), static_cast<int>(sizeof(buffer) - outputLeft));
+
+            if (result == BROTLI_DECODER_RESULT_ERROR)
+            {
+                _errorString = QString("Invalid brotli data: %1")
+                               .arg(BrotliDecoderErrorString(BrotliDecoderGetErrorCode(_state)));
+                return false;
+            }
+            if (result == BROTLI_DECODER_RESULT_SUCCESS)
+                _ended = true;
+            if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT)
+                return true;
+        }
+    }
+
+    bool finish(QByteArray &) override
+    {
+        if (!_ended)
+        {
+            _errorString = "Truncated brotli data";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    BrotliDecoderState * _state;
+    bool                 _ended;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+class ZstdDecoder : public ContentDecoder
+{
+public:
+    ZstdDecoder() :
+        _stream(ZSTD_createDStream()),
+        _pending(0)
+    {
+        ZSTD_initDStream(_stream);
+    }
+
+    ~ZstdDecoder() override
+    {
+        ZSTD_freeDStream(_stream);
+    }
+
+    bool decode(const QByteArray & input, QByteArray & output) override
+    {
+        ZSTD_inBuffer in{input.constData(), static_cast<size_t>(input.size()), 0};
+        char buffer[outputChunkSize];
+        do
+        {
+            ZSTD_outBuffer out{buffer, sizeof(buffer), 0};
+            _pending = ZSTD_decompressStream(_stream, &out, &in);
+            if (ZSTD_isError(_pending))
+            {
+                _errorString = QString("Invalid zstd data: %1").arg(ZSTD_getErrorName(_pending));
+                return false;
+            }
+            output.append(buffer, static_cast<int>(out.pos));
+
+            // A full output buffer may hide data still held by the decoder
+            if (out.pos < out.size && in.pos == in.size)
+                break;
+        } while (true);
+
+        return true;
+    }
+
+    bool finish(QByteArray &) override
+    {
+        // Zero once a whole frame has been decoded and flushed
+        if (_pending != 0)
+        {
+            _errorString = "Truncated zstd data";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    ZSTD_DStream * _stream;
+    size_t         _pending;
+};
+#endif
+
+class ChainDecoder : public ContentDecoder
+{
+public:
+    explicit ChainDecoder(std::vector<std::unique_ptr<ContentDecoder>> decoders) :
+        _decoders(std::move(decoders))
+    {}
+
+    bool decode(const QByteArray & input, QByteArray & output) override
+    {
+        return _run(0, input, output, false);
+    }
+
+    bool finish(QByteArray & output) override
+    {
+        return _run(0, {}, output, true);
+    }
+
+private:
+    bool _run(size_t index, const QByteArray & input, QByteArray & output, bool finish)
+    {
+        if (index == _decoders.size())
+        {
+            output.append(input);
+            return true;
+        }
+
+        auto & decoder = *_decoders.at(index);
+        QByteArray decoded;
+        if (!decoder.decode(input, decoded) || (finish && !decoder.finish(decoded)))
+        {
+            _errorString = decoder.errorString();
+            return false;
+        }
+
+        return _run(index + 1, decoded, output, finish);
+    }
+
+private:
+    std::vector<std::unique_ptr<ContentDecoder>> _decoders;
+};
+
+std::unique_ptr<ContentDecoder> createDecoder(const QByteArray & encoding)
+{
+    if (encoding == "gzip" || encoding == "x-gzip")
+        return std::unique_ptr<ContentDecoder>(new ZlibDecoder(true));
+    if (encoding == "deflate")
+        return std::unique_ptr<ContentDecoder>(new ZlibDecoder(false));
+#ifdef HAVE_BROTLI
+    if (encoding == "br")
+        return std::unique_ptr<ContentDecoder>(new BrotliDecoder);
+#endif
+#ifdef HAVE_ZSTD
+    if (encoding == "zstd")
+        return std::unique_ptr<ContentDecoder>(new ZstdDecoder);
+#endif
+    return nullptr;
+}
+} // !namespace
+
+std::unique_ptr<ContentDecoder> ContentDecoder::create(const QByteArray & contentEncoding)
+{
+    // The encodings are listed in the order they were applied
+    std::vector<std::unique_ptr<ContentDecoder>> decoders;
+    const auto encodings = contentEncoding.toLower().split(',');
+    for (auto itr = encodings.crbegin(); itr != encodings.crend(); ++itr)
+    {
+        const auto encoding = itr->trimmed();
+        if (encoding.isEmpty() || encoding == "identity")
+            continue;
+
+        auto decoder = createDecoder(encoding);
+        if (decoder == nullptr)
+            return nullptr;
+        decoders.push_back(std::move(decoder));
+    }
+
+    if (decoders.empty())
+        return nullptr;
+    if (decoders.size() == 1)
+        return std::move(decoders.front());
+    return std::unique_ptr<ContentDecoder>(new ChainDecoder(std::move(decoders)));
+}
+
+QByteArray ContentDecoder::acceptEncoding()
+{
+    QByteArray value = "gzip, deflate";
+#ifdef HAVE_BROTLI
+    value += ", br";
+#endif
+#ifdef HAVE_ZSTD
+    value += ", zstd";
+#endif
+    return value;
+}
@@ -0,0 +1,47 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QByteArray>
+#include <QString>
+
+// C++ standard library includes -----------------------------------------------
+#include <memory>
+
+// Streaming decoder of a response Content-Encoding, fed the body by chunks as
+// they are read from the network.
+//
+// gzip and deflate are always supported, brotli and zstd when the application
+// is built with their libraries. A body encoded several times is decoded by a
+// chain of decoders, in the reverse order of the encodings.
+class ContentDecoder
+{
+public:
+    virtual ~ContentDecoder() = default;
+
+    // Appends the decoded data to the output
+    virtual bool decode(const QByteArray & input, QByteArray & output) = 0;
+    // Fails when the body was truncated
+    virtual bool finish(QByteArray & output) = 0;
+
+    const QString & errorString() const { return _errorString; }
+
+public:
+    // Null when the body is not encoded or its encoding is not supported, in
+    // which case it is kept as received
+    static std::unique_ptr<ContentDecoder> create(const QByteArray & contentEncoding);
+
+    // Value of the Accept-Encoding header offering all the supported encodings
+    static QByteArray acceptEncoding();
+
+protected:
+    QString _errorString;
+};
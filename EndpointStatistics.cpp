@@ -0,0 +1,99 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "EndpointStatistics.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QRegularExpression>
+
+void EndpointStatistics::add(const Request & request)
+{
+    remove(request.id);
+    if (!request.hasReceiveResponse)
+        return ; // Still waiting for its response
+
+    const auto url = urlTemplate(request.url());
+    const auto key = QString::fromUtf8(request.method) + ' ' + url;
+    auto itr = _endpointIds.constFind(key);
+    if (itr == _endpointIds.constEnd())
+    {
+        Endpoint endpoint;
+        endpoint.method = request.method;
+        endpoint.url    = url;
+        _endpoints.push_back(endpoint);
+        itr = _endpointIds.insert(key, _endpoints.size() - 1);
+    }
+
+    const Sample sample{itr.value(), request.elapsedTime, isError(request)};
+    auto & endpoint = _endpoints[sample.endpoint];
+    endpoint.latencies.add(sample.latency);
+    endpoint.errors += sample.error ? 1 : 0;
+    _samples.insert(request.id, sample);
+}
+
+void EndpointStatistics::remove(quint64 id)
+{
+    const auto itr = _samples.find(id);
+    if (itr == _samples.end())
+        return ;
+
+    auto & endpoint = _endpoints[itr->endpoint];
+    endpoint.latencies.remove(itr->latency);
+    endpoint.errors -= itr->error ? 1 : 0;
+    _samples.erase(itr);
+}
+
+void EndpointStatistics::clear()
+{
+    _endpoints.clear();
+    _endpointIds.clear();
+    _samples.clear();
+}
+
+LatencyHistogram EndpointStatistics::total() const
+{
+    LatencyHistogram histogram;
+    for (const auto & endpoint : _endpoints)
+        histogram.merge(endpoint.latencies);
+    return histogram;
+}
+
+int EndpointStatistics::totalErrors() const
+{
+    auto errors = 0;
+    for (const auto & endpoint : _endpoints)
+        errors += endpoint.errors;
+    return errors;
+}
+
+QString EndpointStatistics::urlTemplate(const QUrl & url)
+{
+    // Numbers, UUIDs and long hexadecimal strings are usually identifiers
+    static const QRegularExpression number("^\\d+$");
+    static const QRegularExpression uuid("^[0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12}$");
+    static const QRegularExpression hex("^[0-9a-fA-F]{16,}$");
+
+    auto segments = url.path().split('/');
+    for (auto & segment : segments)
+        if (number.match(segment).hasMatch())
+            segment = "{id}";
+        else if (uuid.match(segment).hasMatch())
+            segment = "{uuid}";
+        else if (hex.match(segment).hasMatch())
+            segment = "{hex}";
+
+    const auto host = url.port() == -1 ? url.host() : QString("%1:%2").arg(url.host()).arg(url.port());
+    return host + segments.join('/');
+}
+
+bool EndpointStatistics::isError(const Request & request)
+{
+    // A status code of 0 means that no HTTP response was received
+    return request.statusCode == 0 || request.statusCode >= 400;
+}
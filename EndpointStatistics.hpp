@@ -0,0 +1,66 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QHash>
+#include <QVector>
+#include <QUrl>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+#include "LatencyHistogram.hpp"
+
+// Latency statistics of the history, per endpoint.
+//
+// An endpoint is a method and a URL template: the host and the path of the
+// URL, whose segments looking like identifiers are replaced by a placeholder.
+// Each request that received a response is a sample of its endpoint, counted
+// in the latency histogram of the endpoint and, when its status code is 0 or
+// at least 400, in its errors. The samples are replaced when their request is
+// updated, so the statistics are maintained without going through the history.
+class EndpointStatistics
+{
+public:
+    struct Endpoint
+    {
+        QByteArray       method;
+        QString          url;
+        int              errors = 0;
+        LatencyHistogram latencies;
+    };
+
+public:
+    void add(const Request & request);
+    void remove(quint64 id);
+    void clear();
+
+    // Endpoints are never removed, their count drops to 0
+    const QVector<Endpoint> & endpoints() const { return _endpoints; }
+    LatencyHistogram total() const;
+    int totalErrors() const;
+
+public:
+    static QString urlTemplate(const QUrl & url);
+    static bool isError(const Request & request);
+
+private:
+    struct Sample
+    {
+        int     endpoint;
+        quint32 latency;
+        bool    error;
+    };
+
+private:
+    QVector<Endpoint>      _endpoints;
+    QHash<QString, int>    _endpointIds;
+    QHash<quint64, Sample> _samples;
+};
@@ -0,0 +1,125 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "EndpointStatsDialog.hpp"
+
+namespace
+{
+constexpr const auto allEndpoints = -1;
+} // !namespace
+
+EndpointStatsDialog::EndpointStatsDialog(const EndpointStatistics & statistics, QWidget * parent) :
+    QDialog(parent),
+    _statistics(statistics)
+{
+    _ui.setupUi(this);
+    _ui.tableEndpoints->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _ui.tableEndpoints->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+
+    QObject::connect(_ui.tableEndpoints, &QTableWidget::itemSelectionChanged,
+                     this, &EndpointStatsDialog::_onSelectionChanged);
+    QObject::connect(_ui.buttonBox, &QDialogButtonBox::rejected,
+                     this, &EndpointStatsDialog::close);
+}
+
+void EndpointStatsDialog::refresh()
+{
+    if (!isVisible())
+        return ;
+
+    // The selected endpoint stays selected
+    const auto currentItem = _ui.tableEndpoints->currentItem();
+    const auto selectedId  = currentItem == nullptr ? allEndpoints :
+                             _ui.tableEndpoints->item(currentItem->row(), 0)->data(Qt::UserRole).toInt();
+
+    _ui.tableEndpoints->setSortingEnabled(false);
+    _ui.tableEndpoints->setRowCount(0);
+
+    const auto & endpoints = _statistics.endpoints();
+    _fillRow(0, "*", "All endpoints", _statistics.total(), _statistics.totalErrors());
+    _ui.tableEndpoints->item(0, 0)->setData(Qt::UserRole, allEndpoints);
+    for (auto i = 0; i < endpoints.size(); ++i)
+    {
+        const auto & endpoint = endpoints.at(i);
+        if (endpoint.latencies.count() == 0)
+            continue;
+
+        const auto row = _ui.tableEndpoints->rowCount();
+        _fillRow(row, QString::fromUtf8(endpoint.method), endpoint.url, endpoint.latencies, endpoint.errors);
+        _ui.tableEndpoints->item(row, 0)->setData(Qt::UserRole, i);
+    }
+
+    _ui.tableEndpoints->setSortingEnabled(true);
+
+    for (auto row = 0; row < _ui.tableEndpoints->rowCount(); ++row)
+        if (_ui.tableEndpoints->item(row, 0)->data(Qt::UserRole).toInt() == selectedId)
+        {
+            _ui.tableEndpoints->selectRow(row);
+            break;
+        }
+    _onSelectionChanged();
+}
+
+void EndpointStatsDialog::showEvent(QShowEvent * event)
+{
+    QDialog::showEvent(event);
+    refresh();
+}
+
+void EndpointStatsDialog::_fillRow(int row, const QString & method, const QString & url,
+                                   const LatencyHistogram & latencies, int errors)
+{
+    const auto count = latencies.count();
+    _ui.tableEndpoints->insertRow(row);
+    _ui.tableEndpoints->setItem(row, 0, _createTableItem(method));
+    _ui.tableEndpoints->setItem(row, 1, _createTableItem(url));
+    _ui.tableEndpoints->setItem(row, 2, _createTableItem(count));
+    _ui.tableEndpoints->setItem(row, 3, _createTableItem(count == 0 ? 0.0 : 100.0 * errors / count));
+    _ui.tableEndpoints->setItem(row, 4, _createTableItem(latencies.percentile(0.50)));
+    _ui.tableEndpoints->setItem(row, 5, _createTableItem(latencies.percentile(0.90)));
+    _ui.tableEndpoints->setItem(row, 6, _createTableItem(latencies.percentile(0.99)));
+    _ui.tableEndpoints->setItem(row, 7, _createTableItem(latencies.max()));
+}
+
+void EndpointStatsDialog::_onSelectionChanged()
+{
+    const auto currentItem = _ui.tableEndpoints->currentItem();
+    const auto id = currentItem == nullptr ? allEndpoints :
+                    _ui.tableEndpoints->item(currentItem->row(), 0)->data(Qt::UserRole).toInt();
+
+    const auto & endpoints = _statistics.endpoints();
+    if (id == allEndpoints || id >= endpoints.size())
+    {
+        _ui.lHistogram->setText("Latency distribution of all endpoints");
+        _ui.histogram->setHistogram(_statistics.total());
+    }
+    else
+    {
+        const auto & endpoint = endpoints.at(id);
+        _ui.lHistogram->setText(QString("Latency distribution of %1 %2")
+                                .arg(QString::fromUtf8(endpoint.method)).arg(endpoint.url));
+        _ui.histogram->setHistogram(endpoint.latencies);
+    }
+}
+
+QTableWidgetItem * EndpointStatsDialog::_createTableItem(const QString & text)
+{
+    auto item = new QTableWidgetItem(text);
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    return item;
+}
+
+QTableWidgetItem * EndpointStatsDialog::_createTableItem(double value)
+{
+    // Numbers are sorted by value rather than by text
+    auto item = new QTableWidgetItem;
+    item->setData(Qt::DisplayRole, qRound64(value * 10) / 10.0);
+    item->setFlags(item->flags() & ~Qt::ItemIsEditable);
+    return item;
+}
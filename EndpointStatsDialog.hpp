@@ -0,0 +1,50 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QDialog>
+
+// Project includes ------------------------------------------------------------
+#include "ui_EndpointStatsDialog.h"
+#include "EndpointStatistics.hpp"
+
+// Table of the latency statistics of each endpoint of the history, and the
+// latency distribution of the selected one. The first row sums up all the
+// endpoints. The statistics are displayed again whenever they change while the
+// dialog is visible.
+class EndpointStatsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit EndpointStatsDialog(const EndpointStatistics & statistics, QWidget * parent = nullptr);
+
+public slots:
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent * event) override;
+
+private:
+    void _fillRow(int row, const QString & method, const QString & url,
+                  const LatencyHistogram & latencies, int errors);
+
+private slots:
+    void _onSelectionChanged();
+
+private:
+    static QTableWidgetItem * _createTableItem(const QString & text);
+    static QTableWidgetItem * _createTableItem(double value);
+
+private:
+    Ui::EndpointStatsDialog    _ui;
+    const EndpointStatistics & _statistics;
+};
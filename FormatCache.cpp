@@ -0,0 +1,107 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "FormatCache.hpp"
+
+// Project includes ------------------------------------------------------------
+#include "BlobStore.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <limits>
+
+bool FormatCache::Formats::has(Format format) const
+{
+    if (!parsed || !isJson())
+        return parsed;
+    return format == Format::Indented ? !indented.isNull() : tree != nullptr;
+}
+
+FormatCache::FormatCache(int maxCost) :
+    _entries(maxCost)
+{}
+
+FormatCache::Formats FormatCache::find(const Key & key)
+{
+    const auto cached = _entries.object(key);
+    return cached != nullptr ? *cached : Formats();
+}
+
+void FormatCache::insert(const Key & key, const Formats & formats)
+{
+    if (!formats.parsed)
+        return ;
+
+    // Replaces the previous entry. QCache drops an entry exceeding the budget
+    // instead of caching it, so a larger one is counted as the whole budget
+    const auto cost = formats.documentCost + formats.indented.size() + formats.treeCost;
+    _entries.insert(key, new Formats(formats), static_cast<int>(qMin<qint64>(cost, _entries.maxCost())));
+}
+
+void FormatCache::setMaxCost(qint64 cost)
+{
+    _entries.setMaxCost(static_cast<int>(qBound<qint64>(0, cost, std::numeric_limits<int>::max())));
+}
+
+QByteArray FormatCache::indented(const Body & body)
+{
+    const auto data = body.data();
+    const auto k    = key(body, data);
+    auto formats = find(k);
+    if (!formats.has(Format::Indented))
+    {
+        formats = build(formats, data, Format::Indented);
+        insert(k, formats);
+    }
+
+    return formats.isJson() ? formats.indented : data;
+}
+
+FormatCache::Key FormatCache::key(const Body & body, const QByteArray & data)
+{
+    // Stored bodies already know the hash of their content
+    if (hasKey(body))
+        return key(body);
+    return qMakePair(BlobStore::hash(data), static_cast<qint64>(data.size()));
+}
+
+FormatCache::Formats FormatCache::build(Formats formats, const QByteArray & data, Format format,
+                                        const std::atomic<bool> * canceled)
+{
+    // The parsed document takes about the size of its text, a body which is
+    // not JSON is remembered as well so it is not parsed again
+    if (!formats.parsed)
+    {
+        formats.document     = QJsonDocument::fromJson(data);
+        formats.documentCost = formats.isJson() ? data.size() : 1;
+        formats.parsed       = true;
+    }
+
+    if (!formats.isJson() || (canceled != nullptr && *canceled))
+        return formats;
+
+    if (format == Format::Indented && formats.indented.isNull())
+        formats.indented = formats.document.toJson(QJsonDocument::Indented);
+    else if (format == Format::Tree && formats.tree == nullptr)
+    {
+        formats.tree = QJsonModel::build(formats.document);
+        _measureTree(formats.tree.get(), formats);
+    }
+
+    return formats;
+}
+
+void FormatCache::_measureTree(QJsonTreeItem * item, Formats & formats)
+{
+    ++formats.treeItems;
+    const qint64 textSize = item->key().size() + item->value().size();
+    formats.treeCost += static_cast<qint64>(sizeof(QJsonTreeItem) + sizeof(void *)) +
+                        textSize * static_cast<qint64>(sizeof(QChar));
+    for (int i = 0; i < item->childCount(); ++i)
+        _measureTree(item->child(i), formats);
+}
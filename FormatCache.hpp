@@ -0,0 +1,96 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QByteArray>
+#include <QCache>
+#include <QJsonDocument>
+#include <QPair>
+
+// Project includes ------------------------------------------------------------
+#include "Body.hpp"
+#include "QJsonModel.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <atomic>
+
+// Formatted representations of the response bodies: the parsed document, its
+// indented text and its tree.
+//
+// They are built on demand and the most recently displayed ones are kept, up to
+// a size budget, so switching between the display formats or between recent
+// requests does not parse the body again. An entry larger than the budget is
+// kept alone, so the formats of the largest bodies are not parsed again either. The entries are keyed by the content
+// of the bodies, so a modified body is never shown with a stale representation
+// and identical bodies share theirs.
+//
+// The cache itself is only used from the GUI thread, but building the missing
+// representations does not touch it so it can be done by a worker.
+class FormatCache
+{
+public:
+    using Key = QPair<quint64, qint64>;
+
+    enum class Format
+    {
+        Indented,
+        Tree
+    };
+
+    // The document is null once parsed when the body is not JSON
+    struct Formats
+    {
+        bool             parsed       = false;
+        QJsonDocument    document;
+        qint64           documentCost = 1;   // In bytes, like the other costs
+        QByteArray       indented;
+        QJsonTreeItemPtr tree;
+        int              treeItems    = 0;
+        qint64           treeCost     = 0;
+
+        bool isJson() const { return !document.isNull(); }
+        bool has(Format format) const;
+    };
+
+    // Key and representations built by a worker, inserted by the GUI thread
+    using Entry = QPair<Key, Formats>;
+
+public:
+    explicit FormatCache(int maxCost);
+
+    Formats find(const Key & key);
+    void insert(const Key & key, const Formats & formats);
+
+    // Builds synchronously what is missing
+    QByteArray indented(const Body & body);
+
+    int maxCost() const         { return _entries.maxCost(); }
+    void setMaxCost(qint64 cost);
+    int totalCost() const       { return _entries.totalCost(); }
+    void clear()                { _entries.clear(); }
+
+public:
+    // Known without reading the body once it is stored, which hashes it
+    static bool hasKey(const Body & body) { return body.hash() != 0; }
+    static Key key(const Body & body)     { return qMakePair(body.hash(), body.size()); }
+    static Key key(const Body & body, const QByteArray & data);
+
+    // Completes the given representations, stops early and returns them as
+    // they are once canceled
+    static Formats build(Formats formats, const QByteArray & data, Format format,
+                         const std::atomic<bool> * canceled = nullptr);
+
+private:
+    static void _measureTree(QJsonTreeItem * item, Formats & formats);
+
+private:
+    QCache<Key, Formats> _entries;
+};
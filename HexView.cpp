@@ -0,0 +1,203 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "HexView.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QApplication>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QInputDialog>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+namespace
+{
+constexpr const auto textMargin   = 4;
+constexpr const auto offsetDigits = 10;   // Spilled bodies may exceed 4 GiB
+
+// Offset, two spaces, the bytes with an extra space in the middle, two spaces
+// and the characters
+constexpr const auto rowLength    = offsetDigits + 2 + HexView::bytesPerRow * 3 + 1 + 1 + HexView::bytesPerRow;
+constexpr const auto asciiColumn  = rowLength - HexView::bytesPerRow;
+
+const char hexDigits[] = "0123456789abcdef";
+} // !namespace
+
+HexView::HexView(QWidget * parent) :
+    QAbstractScrollArea(parent),
+    _selected(-1)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+}
+
+void HexView::setData(const Body & body)
+{
+    _reader   = BodyReader(body);
+    _selected = -1;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    _updateScrollBars();
+    viewport()->update();
+}
+
+void HexView::clear()
+{
+    setData({});
+}
+
+bool HexView::goToOffset(qint64 offset)
+{
+    if (offset < 0 || offset >= _reader.size())
+        return false;
+
+    // The row is shown at the top of the view, or as close as the end allows
+    _selected = offset;
+    verticalScrollBar()->setValue(static_cast<int>(offset / bytesPerRow));
+    viewport()->update();
+    return true;
+}
+
+QString HexView::visibleText() const
+{
+    const auto rowHeight = fontMetrics().height();
+    const auto first     = verticalScrollBar()->value();
+    const auto last      = qMin(_rowCount(), first + viewport()->height() / rowHeight + 1);
+
+    QStringList rows;
+    for (auto i = first; i < last; ++i)
+        rows.append(_row(i));
+    return rows.join('\n');
+}
+
+void HexView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+    painter.setPen(palette().text().color());
+
+    const auto metrics   = fontMetrics();
+    const auto rowHeight = metrics.height();
+    const auto charWidth = metrics.width(QLatin1Char('0'));
+    const auto first     = verticalScrollBar()->value();
+    const auto x         = textMargin - horizontalScrollBar()->value();
+
+    // Only the visible rows are formatted
+    auto y = 0;
+    for (auto i = first; i < _rowCount() && y < viewport()->height(); ++i)
+    {
+        if (_selected >= 0 && _selected / bytesPerRow == i)
+        {
+            const auto byte = static_cast<int>(_selected % bytesPerRow);
+            painter.fillRect(x + _hexColumn(byte) * charWidth, y, 2 * charWidth, rowHeight, palette().highlight());
+            painter.fillRect(x + (asciiColumn + byte) * charWidth, y, charWidth, rowHeight, palette().highlight());
+        }
+
+        painter.drawText(x, y + metrics.ascent(), _row(i));
+        y += rowHeight;
+    }
+}
+
+void HexView::resizeEvent(QResizeEvent * event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    _updateScrollBars();
+}
+
+void HexView::keyPressEvent(QKeyEvent * event)
+{
+    if (event->matches(QKeySequence::Copy))
+        QGuiApplication::clipboard()->setText(visibleText());
+    else if (event->key() == Qt::Key_G && event->modifiers() == Qt::ControlModifier)
+        _promptOffset();
+    else if (event->matches(QKeySequence::MoveToStartOfDocument))
+        verticalScrollBar()->setValue(0);
+    else if (event->matches(QKeySequence::MoveToEndOfDocument))
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    else if (event->matches(QKeySequence::MoveToNextPage))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepAdd);
+    else if (event->matches(QKeySequence::MoveToPreviousPage))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepSub);
+    else if (event->matches(QKeySequence::MoveToNextLine))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    else if (event->matches(QKeySequence::MoveToPreviousLine))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+void HexView::_promptOffset()
+{
+    if (_reader.size() == 0)
+        return ;
+
+    bool ok = false;
+    const auto text = QInputDialog::getText(this, "Go to offset",
+                                            QString("Offset, decimal or 0x prefixed (0 to %1):").arg(_reader.size() - 1),
+                                            QLineEdit::Normal, {}, &ok);
+    if (!ok || text.trimmed().isEmpty())
+        return ;
+
+    // The base is deduced from the prefix
+    const auto offset = text.trimmed().toLongLong(&ok, 0);
+    if (!ok || !goToOffset(offset))
+        QApplication::beep();
+}
+
+void HexView::_updateScrollBars()
+{
+    const auto metrics     = fontMetrics();
+    const auto rowHeight   = metrics.height();
+    const auto visibleRows = qMax(1, viewport()->height() / rowHeight);
+    verticalScrollBar()->setRange(0, qMax(0, _rowCount() - visibleRows));
+    verticalScrollBar()->setPageStep(visibleRows);
+    verticalScrollBar()->setSingleStep(1);
+
+    const auto rowWidth = rowLength * metrics.width(QLatin1Char('0'));
+    horizontalScrollBar()->setRange(0, qMax(0, rowWidth - viewport()->width() + 2 * textMargin));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(metrics.averageCharWidth() * 4);
+}
+
+int HexView::_rowCount() const
+{
+    return static_cast<int>((_reader.size() + bytesPerRow - 1) / bytesPerRow);
+}
+
+QString HexView::_row(int index) const
+{
+    const auto start = static_cast<qint64>(index) * bytesPerRow;
+    const auto data  = _reader.read(start, bytesPerRow);
+    const auto count = data.size();
+    const auto bytes = reinterpret_cast<const uchar *>(data.constData());
+
+    QString row(rowLength, QLatin1Char(' '));
+    for (auto i = 0; i < offsetDigits; ++i)
+        row[offsetDigits - 1 - i] = QLatin1Char(hexDigits[(start >> (4 * i)) & 0xf]);
+
+    for (auto i = 0; i < count; ++i)
+    {
+        const auto column = _hexColumn(i);
+        row[column]     = QLatin1Char(hexDigits[bytes[i] >> 4]);
+        row[column + 1] = QLatin1Char(hexDigits[bytes[i] & 0xf]);
+        row[asciiColumn + i] = bytes[i] >= 0x20 && bytes[i] < 0x7f ? QLatin1Char(static_cast<char>(bytes[i]))
+                                                                   : QLatin1Char('.');
+    }
+
+    // The last row does not show the characters of missing bytes
+    row.truncate(asciiColumn + count);
+    return row;
+}
+
+int HexView::_hexColumn(int byte)
+{
+    return offsetDigits + 2 + byte * 3 + (byte >= bytesPerRow / 2 ? 1 : 0);
+}
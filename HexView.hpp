@@ -0,0 +1,58 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QAbstractScrollArea>
+
+// Project includes ------------------------------------------------------------
+#include "Body.hpp"
+
+// Hexadecimal and ASCII dump of a binary body, bytesPerRow bytes per row.
+//
+// The body is read by pages, which are windows of its memory mapping when it is
+// stored, and only the rows in the visible window are formatted and drawn, so
+// the size of the body does not matter. Any offset is reached at once with goToOffset(),
+// which Ctrl+G prompts for.
+class HexView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr const int bytesPerRow = 16;
+
+public:
+    explicit HexView(QWidget * parent = nullptr);
+
+    void setData(const Body & body);
+    void clear();
+    bool goToOffset(qint64 offset);
+
+    // Dump of the displayed rows, for a copy
+    QString visibleText() const;
+
+protected:
+    void paintEvent(QPaintEvent * event) override;
+    void resizeEvent(QResizeEvent * event) override;
+    void keyPressEvent(QKeyEvent * event) override;
+
+private:
+    void _promptOffset();
+    void _updateScrollBars();
+    int _rowCount() const;
+    QString _row(int index) const;
+
+private:
+    static int _hexColumn(int byte);
+
+private:
+    mutable BodyReader _reader;
+    qint64             _selected;   // Offset gone to, -1 if none
+};
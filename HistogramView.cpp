@@ -0,0 +1,73 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "HistogramView.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QPainter>
+#include <QVector>
+
+namespace
+{
+constexpr const auto minimumBarWidth = 3;
+} // !namespace
+
+HistogramView::HistogramView(QWidget * parent) :
+    QWidget(parent)
+{
+    setMinimumHeight(100);
+}
+
+void HistogramView::setHistogram(const LatencyHistogram & histogram)
+{
+    _histogram = histogram;
+    update();
+}
+
+void HistogramView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    const auto first = _histogram.firstBucket();
+    if (first == -1)
+    {
+        painter.drawText(rect(), Qt::AlignCenter, "No response");
+        return ;
+    }
+
+    const auto last        = _histogram.lastBucket();
+    const auto textHeight  = fontMetrics().height();
+    const auto chart       = rect().adjusted(0, 0, 0, -textHeight);
+    const auto maxBars     = qMax(1, chart.width() / minimumBarWidth);
+    const auto perBar      = (last - first) / maxBars + 1;
+
+    QVector<int> bars;
+    auto highest = 0;
+    for (auto i = first; i <= last; i += perBar)
+    {
+        auto count = 0;
+        for (auto j = i; j < i + perBar && j <= last; ++j)
+            count += _histogram.bucket(j);
+        bars.push_back(count);
+        highest = qMax(highest, count);
+    }
+
+    const auto barWidth = static_cast<double>(chart.width()) / bars.size();
+    for (auto i = 0; i < bars.size(); ++i)
+    {
+        const auto height = static_cast<double>(bars.at(i)) / highest * chart.height();
+        painter.fillRect(QRectF(i * barWidth, chart.bottom() - height, qMax(1.0, barWidth - 1), height),
+                         palette().highlight());
+    }
+
+    painter.drawText(rect(), Qt::AlignLeft | Qt::AlignBottom,
+                     QString("%1 ms").arg(LatencyHistogram::lowerBound(first)));
+    painter.drawText(rect(), Qt::AlignRight | Qt::AlignBottom,
+                     QString("%1 ms").arg(qMin(_histogram.max(), LatencyHistogram::upperBound(last))));
+    painter.drawText(rect(), Qt::AlignRight | Qt::AlignTop, QString::number(highest));
+}
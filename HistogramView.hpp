@@ -0,0 +1,34 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QWidget>
+
+// Project includes ------------------------------------------------------------
+#include "LatencyHistogram.hpp"
+
+// Bar chart of a LatencyHistogram, from its first to its last non-empty
+// bucket. The buckets are grouped when they do not fit in the width.
+class HistogramView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistogramView(QWidget * parent = nullptr);
+
+    void setHistogram(const LatencyHistogram & histogram);
+
+protected:
+    void paintEvent(QPaintEvent * event) override;
+
+private:
+    LatencyHistogram _histogram;
+};
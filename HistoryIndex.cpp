@@ -0,0 +1,441 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "HistoryIndex.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+const HistoryIndex::Keys emptyKeys;
+
+void insertKey(HistoryIndex::Keys & keys, const HistoryIndex::Key & key)
+{
+    // Requests are mostly added in chronological order, so at the end
+    if (keys.isEmpty() || keys.last() < key)
+        keys.push_back(key);
+    else
+        keys.insert(std::lower_bound(keys.begin(), keys.end(), key), key);
+}
+
+void mergeKeys(HistoryIndex::Keys & keys, HistoryIndex::Keys & added)
+{
+    // Merged in a single pass, whatever the order of the added keys
+    std::sort(added.begin(), added.end());
+    const auto size = keys.size();
+    keys += added;
+    if (size > 0 && !(keys.at(size - 1) < keys.at(size)))
+        std::inplace_merge(keys.begin(), keys.begin() + size, keys.end());
+}
+
+void removeKey(HistoryIndex::Keys & keys, const HistoryIndex::Key & key)
+{
+    const auto itr = std::lower_bound(keys.begin(), keys.end(), key);
+    if (itr != keys.end() && *itr == key)
+        keys.erase(itr);
+}
+
+template <typename Indexes, typename Value>
+void removeIndexedKey(Indexes & indexes, const Value & value, const HistoryIndex::Key & key)
+{
+    // The empty indexes are removed so they do not accumulate
+    const auto keys = indexes.find(value);
+    if (keys == indexes.end())
+        return ;
+
+    removeKey(keys.value(), key);
+    if (keys->isEmpty())
+        indexes.erase(keys);
+}
+
+template <typename Indexes>
+void removeIndexedKeys(Indexes & indexes, const QVector<bool> & removed)
+{
+    for (auto keys = indexes.begin(); keys != indexes.end();)
+    {
+        keys->erase(std::remove_if(keys->begin(), keys->end(), [&removed](const HistoryIndex::Key & key)
+        { return removed.at(key.slot); }), keys->end());
+        if (keys->isEmpty())
+            keys = indexes.erase(keys);
+        else
+            ++keys;
+    }
+}
+
+template <typename Indexes, typename Value>
+const HistoryIndex::Keys * indexedKeys(const Indexes & indexes, const Value & value)
+{
+    const auto keys = indexes.constFind(value);
+    return keys == indexes.constEnd() ? &emptyKeys : &keys.value();
+}
+} // !namespace
+
+void HistoryIndex::insert(const RequestPtr & request)
+{
+    _insertKeys(_store(request));
+    _search.insert(*request);
+    ++_version;
+}
+
+void HistoryIndex::insert(const QVector<RequestPtr> & requests)
+{
+    // The keys of the new requests are merged into the indexes at once
+    Keys                 byDate;
+    QHash<quint32, Keys> byHost;
+    QHash<quint16, Keys> byMethod;
+    QHash<quint16, Keys> byStatus;
+    byDate.reserve(requests.size());
+    for (const auto & request : requests)
+    {
+        const auto   slot   = _store(request);
+        const auto & record = _records.at(slot);
+        const Key key{record.date, record.id, slot};
+        byDate.push_back(key);
+        byHost[record.host].push_back(key);
+        byMethod[record.method].push_back(key);
+        byStatus[record.statusCode].push_back(key);
+    }
+
+    mergeKeys(_byDate, byDate);
+    for (auto itr = byHost.begin(); itr != byHost.end(); ++itr)
+        mergeKeys(_byHost[itr.key()], itr.value());
+    for (auto itr = byMethod.begin(); itr != byMethod.end(); ++itr)
+        mergeKeys(_byMethod[itr.key()], itr.value());
+    for (auto itr = byStatus.begin(); itr != byStatus.end(); ++itr)
+        mergeKeys(_byStatus[itr.key()], itr.value());
+    ++_version;
+}
+
+void HistoryIndex::insertTexts(const SearchIndex::Entries & entries)
+{
+    // The requests removed or indexed again meanwhile are skipped
+    for (auto itr = entries.begin(); itr != entries.end(); ++itr)
+        if (_slots.contains(itr.key()) && !_search.contains(itr.key()))
+            _search.insert(itr.key(), itr.value());
+    ++_version;
+}
+
+void HistoryIndex::remove(quint64 id)
+{
+    const auto itr = _slots.find(id);
+    if (itr == _slots.end())
+        return ;
+
+    const auto slot = itr.value();
+    _removeKeys(slot);
+    _records[slot] = Record();
+    _requests[slot].reset();
+    _freeSlots.push_back(slot);
+    _slots.erase(itr);
+
+    _search.remove(id);
+    ++_version;
+}
+
+void HistoryIndex::remove(const QVector<quint64> & ids)
+{
+    // The keys of the removed slots are dropped in a single pass over each
+    // index, instead of one search and move per request
+    QVector<bool> removed(_records.size(), false);
+    auto count = 0;
+    for (const auto & id : ids)
+    {
+        const auto itr = _slots.find(id);
+        if (itr == _slots.end())
+            continue;
+
+        const auto slot = itr.value();
+        removed[slot] = true;
+        _records[slot] = Record();
+        _requests[slot].reset();
+        _freeSlots.push_back(slot);
+        _slots.erase(itr);
+        _search.remove(id);
+        ++count;
+    }
+
+    if (count == 0)
+        return ;
+
+    _byDate.erase(std::remove_if(_byDate.begin(), _byDate.end(), [&removed](const Key & key)
+    { return removed.at(key.slot); }), _byDate.end());
+    removeIndexedKeys(_byHost,   removed);
+    removeIndexedKeys(_byMethod, removed);
+    removeIndexedKeys(_byStatus, removed);
+    ++_version;
+}
+
+void HistoryIndex::clear()
+{
+    _records.clear();
+    _requests.clear();
+    _freeSlots.clear();
+    _slots.clear();
+
+    _hosts.clear();
+    _paths.clear();
+    _methods.clear();
+
+    _byDate.clear();
+    _byHost.clear();
+    _byMethod.clear();
+    _byStatus.clear();
+
+    _search.clear();
+    _searchResult.clear();
+    ++_version;
+}
+
+qint64 HistoryIndex::memoryUsage() const
+{
+    // Approximation of the arrays and hashes, the interned strings excluded
+    const auto keys = _byDate.capacity() * 4 * static_cast<qint64>(sizeof(Key));
+    return _records.capacity() * static_cast<qint64>(sizeof(Record)) +
+           _requests.capacity() * static_cast<qint64>(sizeof(RequestPtr)) +
+           _slots.capacity() * static_cast<qint64>(sizeof(quint64) + sizeof(int) + sizeof(void *)) +
+           keys;
+}
+
+bool HistoryIndex::contains(const RequestPtr & request) const
+{
+    const auto itr = _slots.constFind(request->id);
+    return itr != _slots.constEnd() && _requests.at(itr.value()) == request;
+}
+
+RequestPtr HistoryIndex::request(quint64 id) const
+{
+    const auto itr = _slots.constFind(id);
+    return itr == _slots.constEnd() ? nullptr : _requests.at(itr.value());
+}
+
+const HistoryIndex::Record * HistoryIndex::record(quint64 id) const
+{
+    const auto itr = _slots.constFind(id);
+    return itr == _slots.constEnd() ? nullptr : &_records.at(itr.value());
+}
+
+QVector<RequestPtr> HistoryIndex::oldest(int count) const
+{
+    QVector<RequestPtr> requests;
+    requests.reserve(qMin(count, _byDate.size()));
+    for (auto i = 0; i < _byDate.size() && i < count; ++i)
+        requests.push_back(_requests.at(_byDate.at(i).slot));
+    return requests;
+}
+
+QVector<int> HistoryIndex::matchingSlots(const Filter & filter) const
+{
+    const auto criteria = filter.text.isEmpty() ? _resolve(filter) : Criteria();
+    const auto keys     = filter.text.isEmpty() ? _smallestKeys(criteria) : &_searchKeys(filter);
+
+    QVector<int> matching;
+    matching.reserve(keys->size());
+    for (const auto & key : *keys)
+        if (criteria.count <= 1 || _matches(_records.at(key.slot), criteria))
+            matching.push_back(key.slot);
+    return matching;
+}
+
+bool HistoryIndex::matches(int slot, const Filter & filter) const
+{
+    const auto   criteria = _resolve(filter);
+    const auto & record   = _records.at(slot);
+    if (!criteria.isValid || !_matches(record, criteria))
+        return false;
+
+    // Same rules as a search, for a single request
+    if (filter.text.isEmpty())
+        return true;
+    if (SearchIndex::canLookUp(filter.text))
+        return _search.matches(record.id, filter.text);
+    return (_hosts.value(record.host) + _paths.value(record.path)).toUtf8().toLower().contains(filter.text);
+}
+
+QVector<RequestPtr> HistoryIndex::find(const Filter & filter, int offset, int limit) const
+{
+    QVector<RequestPtr> requests;
+    if (offset < 0 || limit <= 0)
+        return requests;
+
+    // The search result is already filtered
+    const auto criteria = filter.text.isEmpty() ? _resolve(filter) : Criteria();
+    const auto keys     = filter.text.isEmpty() ? _smallestKeys(criteria) : &_searchKeys(filter);
+
+    // The keys are sorted by date, the page is read from the end
+    requests.reserve(qMin(limit, keys->size()));
+    if (criteria.count <= 1)
+    {
+        for (auto i = keys->size() - 1 - offset; i >= 0 && requests.size() < limit; --i)
+            requests.push_back(_requests.at(keys->at(i).slot));
+        return requests;
+    }
+
+    for (auto i = keys->size() - 1; i >= 0 && requests.size() < limit; --i)
+    {
+        const auto & key = keys->at(i);
+        if (!_matches(_records.at(key.slot), criteria))
+            continue;
+        if (offset > 0)
+            --offset;
+        else
+            requests.push_back(_requests.at(key.slot));
+    }
+
+    return requests;
+}
+
+int HistoryIndex::_store(const RequestPtr & request)
+{
+    const auto url = request->url();
+    Record record;
+    record.id           = request->id;
+    record.date         = request->date.toMSecsSinceEpoch();
+    record.host         = _hosts.intern(url.host());
+    record.path         = _paths.intern(url.path());
+    record.method       = static_cast<quint16>(_methods.intern(request->method));
+    record.statusCode   = static_cast<quint16>(request->statusCode);
+    record.elapsedTime  = request->elapsedTime;
+    record.requestSize  = static_cast<qint32>(qMin<qint64>(request->content.size(), std::numeric_limits<qint32>::max()));
+    record.responseSize = !request->downloadHash.isEmpty() ? request->downloadSize : request->responseContent.size();
+    record.wireSize     = request->wireSize;
+    record.throughput   = static_cast<quint32>(qMin<qint64>(request->throughput, std::numeric_limits<quint32>::max()));
+
+    // An updated request keeps its slot, the slots of the removed ones are
+    // reused
+    auto slot = _slots.value(record.id, -1);
+    if (slot != -1)
+        _removeKeys(slot);
+    else if (!_freeSlots.isEmpty())
+        slot = _freeSlots.takeLast();
+    else
+    {
+        slot = _records.size();
+        _records.push_back({});
+        _requests.push_back({});
+    }
+
+    _records[slot]  = record;
+    _requests[slot] = request;
+    _slots.insert(record.id, slot);
+    return slot;
+}
+
+void HistoryIndex::_insertKeys(int slot)
+{
+    const auto & record = _records.at(slot);
+    const Key key{record.date, record.id, slot};
+    insertKey(_byDate,                      key);
+    insertKey(_byHost[record.host],         key);
+    insertKey(_byMethod[record.method],     key);
+    insertKey(_byStatus[record.statusCode], key);
+}
+
+void HistoryIndex::_removeKeys(int slot)
+{
+    const auto & record = _records.at(slot);
+    const Key key{record.date, record.id, slot};
+    removeKey(_byDate, key);
+    removeIndexedKey(_byHost,   record.host,       key);
+    removeIndexedKey(_byMethod, record.method,     key);
+    removeIndexedKey(_byStatus, record.statusCode, key);
+}
+
+HistoryIndex::Criteria HistoryIndex::_resolve(const Filter & filter) const
+{
+    Criteria criteria;
+    if (!filter.host.isEmpty())
+    {
+        criteria.host     = _hosts.find(filter.host);
+        criteria.isValid &= criteria.host >= 0;
+        ++criteria.count;
+    }
+    if (!filter.method.isEmpty())
+    {
+        criteria.method   = _methods.find(filter.method);
+        criteria.isValid &= criteria.method >= 0;
+        ++criteria.count;
+    }
+    if (filter.statusCode >= 0)
+    {
+        criteria.statusCode = filter.statusCode;
+        ++criteria.count;
+    }
+
+    return criteria;
+}
+
+const HistoryIndex::Keys * HistoryIndex::_smallestKeys(const Criteria & criteria) const
+{
+    if (!criteria.isValid)
+        return &emptyKeys;
+
+    QVector<const Keys *> candidates;
+    if (criteria.host >= 0)
+        candidates.push_back(indexedKeys(_byHost, static_cast<quint32>(criteria.host)));
+    if (criteria.method >= 0)
+        candidates.push_back(indexedKeys(_byMethod, static_cast<quint16>(criteria.method)));
+    if (criteria.statusCode >= 0)
+        candidates.push_back(indexedKeys(_byStatus, static_cast<quint16>(criteria.statusCode)));
+
+    if (candidates.isEmpty())
+        return &_byDate;
+
+    return *std::min_element(candidates.begin(), candidates.end(),
+                             [](const Keys * v1, const Keys * v2)
+    { return v1->size() < v2->size(); });
+}
+
+const HistoryIndex::Keys & HistoryIndex::_searchKeys(const Filter & filter) const
+{
+    if (_searchVersion == _version && _searchFilter == filter)
+        return _searchResult;
+
+    _searchResult.clear();
+    const auto criteria = _resolve(filter);
+    if (criteria.isValid && SearchIndex::canLookUp(filter.text))
+    {
+        const auto ids = _search.find(filter.text);
+        for (const auto & id : ids)
+        {
+            const auto itr = _slots.constFind(id);
+            if (itr == _slots.constEnd())
+                continue;
+
+            const auto & record = _records.at(itr.value());
+            if (_matches(record, criteria))
+                _searchResult.push_back({record.date, record.id, itr.value()});
+        }
+    }
+    else if (criteria.isValid)
+    {
+        // Queries too short to be looked up are only searched in the hosts and
+        // paths, which does not need the requests
+        for (const auto & key : *_smallestKeys(criteria))
+        {
+            const auto & record = _records.at(key.slot);
+            if (_matches(record, criteria) &&
+                (_hosts.value(record.host) + _paths.value(record.path)).toUtf8().toLower().contains(filter.text))
+                _searchResult.push_back(key);
+        }
+    }
+    std::sort(_searchResult.begin(), _searchResult.end());
+
+    _searchFilter  = filter;
+    _searchVersion = _version;
+    return _searchResult;
+}
+
+bool HistoryIndex::_matches(const Record & record, const Criteria & criteria)
+{
+    return (criteria.host < 0       || record.host == criteria.host) &&
+           (criteria.method < 0     || record.method == criteria.method) &&
+           (criteria.statusCode < 0 || record.statusCode == criteria.statusCode);
+}
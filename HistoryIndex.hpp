@@ -0,0 +1,162 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QHash>
+#include <QVector>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+#include "SearchIndex.hpp"
+#include "StringPool.hpp"
+
+// Indexes of the history requests.
+//
+// Each request is described by a small record holding the metadata needed to
+// list, sort, filter and count the requests. The records are kept in a
+// contiguous array, apart from the requests themselves whose headers and
+// bodies are only accessed when a page of requests is read. The strings of the
+// records are interned.
+//
+// The records are indexed by date and, still ordered by date, by host, method
+// and status code. A page of the requests matching a filter can then be read,
+// newest first, without going through the whole history: when a single
+// criterion is used the page is directly read from its index, otherwise only
+// the records of the smallest index of the criteria are scanned.
+//
+// The text of the requests is looked up in a SearchIndex, maintained along the
+// other indexes. The requests inserted by batches, when the history is
+// loaded, are not indexed: their texts are indexed by a worker, which reads
+// their bodies, and inserted with insertTexts(). The result of the last search
+// is kept until the history changes so reading its pages does not search
+// again.
+class HistoryIndex
+{
+public:
+    struct Filter
+    {
+        QString    host;
+        QByteArray method;
+        qint32     statusCode = -1;
+        QByteArray text;        // Normalized by SearchIndex::normalize()
+
+        bool isEmpty() const
+        { return host.isEmpty() && method.isEmpty() && statusCode < 0 && text.isEmpty(); }
+        bool operator==(const Filter & other) const
+        { return host == other.host && method == other.method &&
+                 statusCode == other.statusCode && text == other.text; }
+    };
+
+    struct Record
+    {
+        quint64 id           = 0;
+        qint64  date         = 0;   // Milliseconds since epoch
+        qint64  responseSize = 0;
+        qint64  wireSize     = 0;   // Response size before its decoding
+        quint32 host         = 0;   // Interned in hosts()
+        quint32 path         = 0;   // Interned in paths()
+        quint16 method       = 0;   // Interned in methods()
+        quint16 statusCode   = 0;
+        quint32 elapsedTime  = 0;
+        qint32  requestSize  = 0;   // Saturated, as large requests are not built
+        quint32 throughput   = 0;   // Bytes per second, saturated
+    };
+
+    // Ordered by date then id, the slot is the position of the record
+    struct Key
+    {
+        qint64  date;
+        quint64 id;
+        int     slot;
+
+        bool operator<(const Key & other) const
+        { return date < other.date || (date == other.date && id < other.id); }
+        bool operator==(const Key & other) const
+        { return date == other.date && id == other.id; }
+    };
+    using Keys = QVector<Key>;
+
+public:
+    void insert(const RequestPtr & request);
+    // The texts of the requests are not indexed
+    void insert(const QVector<RequestPtr> & requests);
+    void insertTexts(const SearchIndex::Entries & entries);
+    void remove(quint64 id);
+    void remove(const QVector<quint64> & ids);
+    void clear();
+
+    int size() const { return _slots.size(); }
+    qint64 memoryUsage() const;
+    bool contains(const RequestPtr & request) const;
+    RequestPtr request(quint64 id) const;
+    const Record * record(quint64 id) const;
+    QVector<RequestPtr> oldest(int count) const;
+
+    // A slot stays valid until its request is removed, updating the request
+    // does not change its slot
+    int slot(quint64 id) const              { return _slots.value(id, -1); }
+    int slotCount() const                   { return _records.size(); }
+    const Record & recordAt(int slot) const { return _records.at(slot); }
+    RequestPtr requestAt(int slot) const    { return _requests.at(slot); }
+
+    const StringPool<QString> & hosts() const      { return _hosts; }
+    const StringPool<QString> & paths() const      { return _paths; }
+    const StringPool<QByteArray> & methods() const { return _methods; }
+
+    // Slots of the requests matching the filter, ordered by date
+    QVector<int> matchingSlots(const Filter & filter) const;
+    bool matches(int slot, const Filter & filter) const;
+    QVector<RequestPtr> find(const Filter & filter, int offset, int limit) const;
+
+private:
+    // Filter resolved against the interned strings
+    struct Criteria
+    {
+        qint64 host       = -1;
+        qint64 method     = -1;
+        qint32 statusCode = -1;
+        int    count      = 0;
+        bool   isValid    = true;   // False if a value is not in the history
+    };
+
+    int _store(const RequestPtr & request);
+    void _insertKeys(int slot);
+    void _removeKeys(int slot);
+
+    Criteria _resolve(const Filter & filter) const;
+    const Keys * _smallestKeys(const Criteria & criteria) const;
+    const Keys & _searchKeys(const Filter & filter) const;
+
+private:
+    static bool _matches(const Record & record, const Criteria & criteria);
+
+private:
+    QVector<Record>     _records;
+    QVector<RequestPtr> _requests;
+    QVector<int>        _freeSlots;
+    QHash<quint64, int> _slots;
+
+    StringPool<QString>    _hosts;
+    StringPool<QString>    _paths;
+    StringPool<QByteArray> _methods;
+
+    Keys                 _byDate;
+    QHash<quint32, Keys> _byHost;
+    QHash<quint16, Keys> _byMethod;
+    QHash<quint16, Keys> _byStatus;
+    quint64              _version = 0;
+    SearchIndex          _search;
+
+    // Cached by the const lookups
+    mutable Filter      _searchFilter;
+    mutable quint64     _searchVersion = 0;
+    mutable Keys        _searchResult;
+};
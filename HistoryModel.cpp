@@ -0,0 +1,422 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "HistoryModel.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QDateTime>
+
+// C++ standard library includes -----------------------------------------------
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+constexpr const auto maxRemovedRanges  = 64;
+constexpr const auto maxInsertedRanges = 64;
+
+// Rank of each interned value in the order of the values
+template <typename T>
+QVector<int> ranks(const StringPool<T> & pool)
+{
+    QVector<quint32> ids(pool.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    std::sort(ids.begin(), ids.end(), [&pool](quint32 v1, quint32 v2)
+    { return pool.value(v1) < pool.value(v2); });
+
+    QVector<int> result(pool.size());
+    for (int i = 0; i < ids.size(); ++i)
+        result[static_cast<int>(ids.at(i))] = i;
+    return result;
+}
+} // !namespace
+
+HistoryModel::HistoryModel(const HistoryIndex & index, QObject * parent) :
+    QAbstractTableModel(parent),
+    _index(index),
+    _sortColumn(Date),
+    _sortOrder(Qt::DescendingOrder)
+{}
+
+int HistoryModel::rowCount(const QModelIndex & parent) const
+{
+    return parent.isValid() ? 0 : _slots.size();
+}
+
+int HistoryModel::columnCount(const QModelIndex & parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant HistoryModel::data(const QModelIndex & index, int role) const
+{
+    if (!index.isValid() || index.row() >= _slots.size() || role != Qt::DisplayRole)
+        return {};
+
+    const auto   slot   = _slots.at(index.row());
+    const auto & record = _index.recordAt(slot);
+    if (record.id == 0)
+        return {}; // Removed while the rows were not refreshed yet
+
+    switch (index.column())
+    {
+        case Method:     return QString::fromUtf8(_index.methods().value(record.method));
+        case Url:        return _index.requestAt(slot)->url().toString();
+        case Response:   return QString("%1 %2").arg(record.statusCode).arg(_index.requestAt(slot)->reasonPhrase);
+        case Date:       return QDateTime::fromMSecsSinceEpoch(record.date).toString(dateFormat);
+        case Size:       return _formatSize(record);
+        case Time:       return QString("%1 ms").arg(record.elapsedTime);
+        case Throughput: return record.throughput == 0 ? QString() : QString("%1/s").arg(formatSize(record.throughput));
+    }
+
+    return {};
+}
+
+QVariant HistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section)
+    {
+        case Method:     return "Method";
+        case Url:        return "Request";
+        case Response:   return "Response";
+        case Date:       return "Date";
+        case Size:       return "Size";
+        case Time:       return "Time";
+        case Throughput: return "Throughput";
+    }
+
+    return {};
+}
+
+void HistoryModel::sort(int column, Qt::SortOrder order)
+{
+    _sortColumn = column;
+    _sortOrder  = order;
+
+    // The selection and the current row follow their request
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const auto persistentIndexes = persistentIndexList();
+    QVector<int> persistentSlots;
+    persistentSlots.reserve(persistentIndexes.size());
+    for (const auto & index : persistentIndexes)
+        persistentSlots.push_back(_slots.at(index.row()));
+
+    _sortSlots();
+    _updateRows();
+
+    QModelIndexList newIndexes;
+    newIndexes.reserve(persistentIndexes.size());
+    for (int i = 0; i < persistentIndexes.size(); ++i)
+        newIndexes.push_back(index(_rows.at(persistentSlots.at(i)), persistentIndexes.at(i).column()));
+    changePersistentIndexList(persistentIndexes, newIndexes);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void HistoryModel::refresh()
+{
+    beginResetModel();
+    _slots = _index.matchingSlots(_filter);
+    _methodRanks.clear();
+    _hostRanks.clear();
+    _pathRanks.clear();
+    _sortSlots();
+    _updateRows();
+    endResetModel();
+}
+
+void HistoryModel::requestAdded(const RequestPtr & request)
+{
+    const auto slot = _index.slot(request->id);
+    if (slot < 0 || row(request) != -1 || !_index.matches(slot, _filter))
+        return ;
+
+    // The rows are already sorted, only the following ones move
+    _updateRanks();
+    const auto itr = std::upper_bound(_slots.begin(), _slots.end(), slot,
+                                      [this](int s1, int s2) { return _lessThan(s1, s2); });
+    const auto newRow = static_cast<int>(itr - _slots.begin());
+
+    beginInsertRows({}, newRow, newRow);
+    _slots.insert(newRow, slot);
+    _updateRows(newRow);
+    endInsertRows();
+}
+
+void HistoryModel::requestsAdded(const QVector<RequestPtr> & requests)
+{
+    QVector<int> addedSlots;
+    addedSlots.reserve(requests.size());
+    for (const auto & request : requests)
+    {
+        const auto slot = _index.slot(request->id);
+        if (slot >= 0 && row(request) == -1 && _index.matches(slot, _filter))
+            addedSlots.push_back(slot);
+    }
+
+    if (addedSlots.isEmpty())
+        return ;
+
+    // The rows are inserted by contiguous ranges, each at the position of its
+    // first row among the current rows
+    _updateRanks();
+    const auto lessThan = [this](int s1, int s2) { return _lessThan(s1, s2); };
+    std::sort(addedSlots.begin(), addedSlots.end(), lessThan);
+    QVector<QPair<int, int>> ranges;
+    auto position = _slots.begin();
+    for (int i = 0; i < addedSlots.size(); ++i)
+    {
+        position = std::upper_bound(position, _slots.end(), addedSlots.at(i), lessThan);
+        const auto insertedRow = static_cast<int>(position - _slots.begin());
+        if (ranges.isEmpty() || ranges.last().first != insertedRow)
+            ranges.push_back(qMakePair(insertedRow, i));
+    }
+
+    // Many scattered rows are cheaper to append then sort with the others,
+    // which keeps the selection and the current row
+    if (ranges.size() > maxInsertedRanges)
+    {
+        beginInsertRows({}, _slots.size(), _slots.size() + addedSlots.size() - 1);
+        const auto from = _slots.size();
+        _slots += addedSlots;
+        _updateRows(from);
+        endInsertRows();
+        sort(_sortColumn, _sortOrder);
+        return ;
+    }
+
+    // From the last range so the previous rows do not move
+    auto end = addedSlots.size();
+    for (auto itr = ranges.crbegin(); itr != ranges.crend(); ++itr)
+    {
+        const auto count = end - itr->second;
+        beginInsertRows({}, itr->first, itr->first + count - 1);
+        _slots.insert(itr->first, count, 0);
+        std::copy(addedSlots.begin() + itr->second, addedSlots.begin() + end, _slots.begin() + itr->first);
+        _updateRows(itr->first);
+        endInsertRows();
+        end = itr->second;
+    }
+}
+
+void HistoryModel::requestUpdated(const RequestPtr & request)
+{
+    const auto slot       = _index.slot(request->id);
+    const auto updatedRow = row(request);
+    if (slot < 0)
+        return ;
+
+    // The response may change whether the request matches the filter
+    const auto matches = _index.matches(slot, _filter);
+    if (updatedRow == -1 || !matches)
+    {
+        if (updatedRow == -1 && matches)
+            requestAdded(request);
+        else if (updatedRow != -1)
+            removeRequests({request});
+        return ;
+    }
+
+    // And its sorted position, the other rows are still sorted
+    _updateRanks();
+    const auto lessThan = [this](int s1, int s2) { return _lessThan(s1, s2); };
+    auto newRow = static_cast<int>(std::upper_bound(_slots.begin(), _slots.begin() + updatedRow,
+                                                    slot, lessThan) - _slots.begin());
+    if (newRow == updatedRow)
+        newRow = static_cast<int>(std::upper_bound(_slots.begin() + updatedRow + 1, _slots.end(),
+                                                   slot, lessThan) - _slots.begin()) - 1;
+
+    if (newRow != updatedRow)
+    {
+        beginMoveRows({}, updatedRow, updatedRow, {}, newRow > updatedRow ? newRow + 1 : newRow);
+        _slots.remove(updatedRow);
+        _slots.insert(newRow, slot);
+        _updateRows(qMin(updatedRow, newRow));
+        endMoveRows();
+    }
+
+    emit dataChanged(index(newRow, 0), index(newRow, ColumnCount - 1));
+}
+
+void HistoryModel::removeRequests(const QVector<RequestPtr> & requests)
+{
+    QVector<int> removedRows;
+    removedRows.reserve(requests.size());
+    for (const auto & request : requests)
+    {
+        const auto removedRow = row(request);
+        if (removedRow != -1)
+            removedRows.push_back(removedRow);
+    }
+
+    if (removedRows.isEmpty())
+        return ;
+
+    // The rows are removed by contiguous ranges, from the last one so the
+    // previous rows do not move
+    std::sort(removedRows.begin(), removedRows.end());
+    removedRows.erase(std::unique(removedRows.begin(), removedRows.end()), removedRows.end());
+    QVector<QPair<int, int>> ranges;
+    for (const auto & removedRow : removedRows)
+        if (!ranges.isEmpty() && ranges.last().second + 1 == removedRow)
+            ranges.last().second = removedRow;
+        else
+            ranges.push_back(qMakePair(removedRow, removedRow));
+
+    // Many scattered rows are cheaper to remove with a single reset
+    if (ranges.size() > maxRemovedRanges)
+    {
+        QVector<int> remainingSlots;
+        remainingSlots.reserve(_slots.size() - removedRows.size());
+        auto removedRow = removedRows.cbegin();
+        for (int row = 0; row < _slots.size(); ++row)
+            if (removedRow != removedRows.cend() && *removedRow == row)
+                ++removedRow;
+            else
+                remainingSlots.push_back(_slots.at(row));
+
+        beginResetModel();
+        _slots = remainingSlots;
+        _updateRows();
+        endResetModel();
+        return ;
+    }
+
+    for (auto itr = ranges.crbegin(); itr != ranges.crend(); ++itr)
+    {
+        beginRemoveRows({}, itr->first, itr->second);
+        _slots.remove(itr->first, itr->second - itr->first + 1);
+        endRemoveRows();
+    }
+    _updateRows();
+}
+
+RequestPtr HistoryModel::request(int row) const
+{
+    if (row < 0 || row >= _slots.size())
+        return nullptr;
+    return _index.requestAt(_slots.at(row));
+}
+
+int HistoryModel::row(const RequestPtr & request) const
+{
+    const auto slot = _index.slot(request->id);
+    if (slot < 0 || slot >= _rows.size())
+        return -1;
+    return _rows.at(slot);
+}
+
+qint64 HistoryModel::memoryUsage() const
+{
+    const auto ints = _slots.capacity() + _rows.capacity() +
+                      _methodRanks.capacity() + _hostRanks.capacity() + _pathRanks.capacity();
+    return ints * static_cast<qint64>(sizeof(int));
+}
+
+QString HistoryModel::_formatSize(const HistoryIndex::Record & record)
+{
+    // The size on the wire is only shown when the body was decoded
+    if (record.wireSize == 0 || record.wireSize == record.responseSize)
+        return formatSize(record.responseSize);
+    return QString("%1 (%2 encoded)").arg(formatSize(record.responseSize)).arg(formatSize(record.wireSize));
+}
+
+QString HistoryModel::formatSize(qint64 size)
+{
+    static const auto f = [](const qint64 value, const qint64 factor)
+    {
+        const auto val = (value % factor) / (factor / 10);
+        if (val == 0)
+            return QString::number(value / factor);
+        else
+            return QString("%1.%2").arg(value / factor).arg(val);
+    };
+
+    if (size < 1024)
+        return QString("%1 B").arg(size);
+    else if (size < 1024 * 1024)
+        return QString("%1 kB").arg(f(size, 1024));
+    else if (size < 1024 * 1024 * 1024)
+        return QString("%1 MB").arg(f(size , 1024 * 1024));
+    else
+        return QString("%1 GB").arg(f(size , 1024 * 1024 * 1024));
+}
+
+void HistoryModel::_sortSlots()
+{
+    _updateRanks();
+    std::sort(_slots.begin(), _slots.end(), [this](int s1, int s2) { return _lessThan(s1, s2); });
+}
+
+void HistoryModel::_updateRanks()
+{
+    // Only the strings of the sort column are ranked, again when new ones
+    // were interned
+    if (_sortColumn == Method && _methodRanks.size() != _index.methods().size())
+        _methodRanks = ranks(_index.methods());
+    else if (_sortColumn == Url && (_hostRanks.size() != _index.hosts().size() ||
+                                    _pathRanks.size() != _index.paths().size()))
+    {
+        _hostRanks = ranks(_index.hosts());
+        _pathRanks = ranks(_index.paths());
+    }
+}
+
+void HistoryModel::_updateRows(int from)
+{
+    if (from == 0)
+        _rows.fill(-1, _index.slotCount());
+    else if (_rows.size() < _index.slotCount())
+        _rows.insert(_rows.end(), _index.slotCount() - _rows.size(), -1);
+
+    for (int row = from; row < _slots.size(); ++row)
+        _rows[_slots.at(row)] = row;
+}
+
+bool HistoryModel::_lessThan(int slot1, int slot2) const
+{
+    if (_sortOrder == Qt::DescendingOrder)
+        std::swap(slot1, slot2);
+
+    // Equal values are ordered by date
+    const auto & r1 = _index.recordAt(slot1);
+    const auto & r2 = _index.recordAt(slot2);
+    switch (_sortColumn)
+    {
+        case Method:
+            if (r1.method != r2.method)
+                return _methodRanks.at(r1.method) < _methodRanks.at(r2.method);
+            break;
+        case Url:
+            if (r1.host != r2.host)
+                return _hostRanks.at(static_cast<int>(r1.host)) < _hostRanks.at(static_cast<int>(r2.host));
+            if (r1.path != r2.path)
+                return _pathRanks.at(static_cast<int>(r1.path)) < _pathRanks.at(static_cast<int>(r2.path));
+            break;
+        case Response:
+            if (r1.statusCode != r2.statusCode)
+                return r1.statusCode < r2.statusCode;
+            break;
+        case Size:
+            if (r1.responseSize != r2.responseSize)
+                return r1.responseSize < r2.responseSize;
+            break;
+        case Time:
+            if (r1.elapsedTime != r2.elapsedTime)
+                return r1.elapsedTime < r2.elapsedTime;
+            break;
+        case Throughput:
+            if (r1.throughput != r2.throughput)
+                return r1.throughput < r2.throughput;
+            break;
+    }
+    return qMakePair(r1.date, r1.id) < qMakePair(r2.date, r2.id);
+}
@@ -0,0 +1,96 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QAbstractTableModel>
+#include <QVector>
+
+// Project includes ------------------------------------------------------------
+#include "HistoryIndex.hpp"
+
+// Table model of the history.
+//
+// Each row only references the slot of its record in the HistoryIndex: the
+// cells are produced when the view displays them, from the record and, for the
+// URL and the reason phrase, from the request. Rows are sorted on the typed
+// values of the records, the interned strings being compared by rank.
+//
+// The row of each slot is maintained along the rows so the row of a request
+// is found without going through the rows. New requests are inserted at their
+// sorted position instead of sorting the rows again.
+class HistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        Method,
+        Url,
+        Response,
+        Date,
+        Size,
+        Time,
+        Throughput,
+        ColumnCount
+    };
+
+    static constexpr const auto dateFormat = "dd MMM yyyy - HH:mm:ss";
+
+public:
+    explicit HistoryModel(const HistoryIndex & index, QObject * parent = nullptr);
+
+    int rowCount(const QModelIndex & parent = {}) const override;
+    int columnCount(const QModelIndex & parent = {}) const override;
+    QVariant data(const QModelIndex & index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    void sort(int column, Qt::SortOrder order) override;
+
+    // The filter is applied by the next refresh
+    void setFilter(const HistoryIndex::Filter & filter) { _filter = filter; }
+    void refresh();
+    void requestAdded(const RequestPtr & request);
+    void requestsAdded(const QVector<RequestPtr> & requests);
+    // Moves the row of the request to its new sorted position, or adds or
+    // removes it when it now matches the filter or not
+    void requestUpdated(const RequestPtr & request);
+    // To call before the requests are removed from the index
+    void removeRequests(const QVector<RequestPtr> & requests);
+
+    RequestPtr request(int row) const;
+    int row(const RequestPtr & request) const;
+    qint64 memoryUsage() const;
+
+public:
+    static QString formatSize(qint64 size);
+
+private:
+    void _sortSlots();
+    void _updateRanks();
+    void _updateRows(int from = 0);
+    bool _lessThan(int slot1, int slot2) const;
+
+private:
+    static QString _formatSize(const HistoryIndex::Record & record);
+
+private:
+    const HistoryIndex & _index;
+    HistoryIndex::Filter _filter;
+    QVector<int>         _slots;
+    QVector<int>         _rows;     // Row of each slot, -1 if not displayed
+    int                  _sortColumn;
+    Qt::SortOrder        _sortOrder;
+
+    // Order of the interned strings of the sort column
+    QVector<int>         _methodRanks;
+    QVector<int>         _hostRanks;
+    QVector<int>         _pathRanks;
+};
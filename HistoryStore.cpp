@@ -0,0 +1,995 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "HistoryStore.hpp"
+#include "Constants.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QtConcurrent>
+
+// C++ standard library includes -----------------------------------------------
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+constexpr const quint32 journalMagic         = 0x4a515248; // "HRQJ"
+constexpr const quint32 journalVersion       = 9;
+constexpr const auto    compactionThreshold  = 256;
+
+QString baseFilename(const QString & basePath)    { return basePath + ".base"; }
+QString journalFilename(const QString & basePath) { return basePath + ".journal"; }
+QString oldFilename(const QString & basePath)     { return basePath + ".journal.old"; }
+QString legacyFilename(const QString & basePath)  { return basePath + ".history"; }
+
+void setupStream(QDataStream & stream)
+{
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setVersion(QDataStream::Qt_5_6);
+}
+
+void writeHeader(QDataStream & out)
+{
+    out << journalMagic << journalVersion;
+}
+
+bool readHeader(QDataStream & in, quint32 & version)
+{
+    quint32 magic = 0;
+    in >> magic >> version;
+    return in.status() == QDataStream::Ok &&
+           magic == journalMagic &&
+           version >= 1 && version <= journalVersion;
+}
+
+quint16 checksum(const QByteArray & payload)
+{
+    return qChecksum(payload.constData(), static_cast<uint>(payload.size()));
+}
+
+void writeRecord(QDataStream & out, quint8 operation, quint64 id, const QByteArray & payload)
+{
+    out << operation << id << payload << checksum(payload);
+}
+
+void writeBody(QDataStream & out, const Body & body)
+{
+    const auto & location = body.location();
+    out << location.generation << location.offset << body.size() << body.hash();
+    out << static_cast<quint8>(location.codec) << location.size;
+}
+
+// The sizes were 32 bits before the ninth version
+qint64 readSize(QDataStream & in, quint32 version)
+{
+    if (version >= 9)
+    {
+        qint64 size = 0;
+        in >> size;
+        return size;
+    }
+
+    qint32 size = 0;
+    in >> size;
+    return size;
+}
+
+void readBody(QDataStream & in, Body & body, quint32 version)
+{
+    Body::Location location;
+    quint64 hash = 0;
+    in >> location.generation >> location.offset;
+    const auto size = readSize(in, version);
+    if (version >= 3)
+        in >> hash;
+
+    // Bodies were always written uncompressed before the fourth version
+    location.size = size;
+    if (version >= 4)
+    {
+        quint8 codec = 0;
+        in >> codec;
+        location.codec = static_cast<Body::Codec>(codec);
+        location.size  = readSize(in, version);
+    }
+
+    body = Body();
+    if (location.generation != 0)
+        body.setLocation(location, size, hash);
+}
+
+void readTimings(QDataStream & in, RequestTimings & timings, quint32 version)
+{
+    // Same layout as the RequestTimings operator since the seventh version,
+    // only the total elapsed time was recorded before the fifth one
+    timings = RequestTimings();
+    if (version >= 7)
+        in >> timings;
+    else if (version >= 5)
+    {
+        in >> timings.queued >> timings.resolved >> timings.encrypted;
+        in >> timings.sent >> timings.firstByte >> timings.lastByte;
+    }
+}
+
+// Same layout as operator<<(QDataStream &, const Request &) except that the
+// bodies are replaced by their location in the body files and the timings of
+// the phases, the throughput, the size on the wire and the downloaded file
+// follow the elapsed time
+void writeRequest(QDataStream & out, const Request & request)
+{
+    out << request.url();
+    out << request.method;
+    out << request.requestHeaders();
+
+    out << request.hasContent;
+    out << request.contentIsFilename;
+    writeBody(out, request.content);
+
+    out << request.hasReceiveResponse;
+    out << request.statusCode;
+    out << request.reasonPhrase;
+    writeBody(out, request.responseContent);
+    out << request.responseHeaders;
+
+    out << request.date;
+    out << request.elapsedTime;
+    out << request.timings;
+    out << request.throughput;
+    out << request.wireSize;
+    out << request.downloadPath << request.downloadSize << request.downloadHash;
+
+    out << request.displayFormat;
+}
+
+void readRequest(QDataStream & in, Request & request, quint32 version)
+{
+    QUrl url;
+    in >> url;
+    request.setUrl(url);
+
+    in >> request.method;
+
+    Request::Headers headers;
+    in >> headers;
+    request.setRequestHeaders(headers);
+
+    in >> request.hasContent;
+    in >> request.contentIsFilename;
+    readBody(in, request.content, version);
+
+    in >> request.hasReceiveResponse;
+    in >> request.statusCode;
+    in >> request.reasonPhrase;
+    readBody(in, request.responseContent, version);
+    in >> request.responseHeaders;
+
+    in >> request.date;
+    in >> request.elapsedTime;
+    readTimings(in, request.timings, version);
+    request.throughput = 0;
+    if (version >= 6)
+        in >> request.throughput;
+
+    // The bodies were stored as received before the seventh version
+    request.wireSize = request.responseContent.size();
+    if (version >= 7)
+        in >> request.wireSize;
+
+    request.downloadPath.clear();
+    request.downloadSize = 0;
+    request.downloadHash.clear();
+    if (version >= 8)
+        in >> request.downloadPath >> request.downloadSize >> request.downloadHash;
+
+    in >> request.displayFormat;
+}
+
+QByteArray serialize(const Request & request)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    setupStream(out);
+    writeRequest(out, request);
+    return payload;
+}
+} // !namespace
+
+HistoryStore::HistoryStore(QObject * parent) :
+    QObject(parent),
+    _nextId(1),
+    _liveCount(0),
+    _journalRecords(0),
+    _nextCompaction(compactionThreshold),
+    _loading(false),
+    _loadBatchSize(0),
+    _resident(Constants::memoryBudget)
+{
+    QObject::connect(&_loader, &QFutureWatcher<LoadResult>::finished,
+                     this, &HistoryStore::_onLoaded);
+    QObject::connect(&_indexer, &QFutureWatcher<SearchIndex::Entries>::finished,
+                     this, &HistoryStore::_insertTexts);
+
+    // A batch is loaded per event loop iteration so the view is updated and
+    // stays responsive in between
+    _batchTimer.setSingleShot(true);
+    _batchTimer.setInterval(0);
+    QObject::connect(&_batchTimer, &QTimer::timeout,
+                     this, &HistoryStore::_loadNextBatch);
+}
+
+HistoryStore::~HistoryStore()
+{
+    close();
+}
+
+void HistoryStore::open(const QString & basePath)
+{
+    close();
+    _basePath = basePath;
+    _index.clear();
+
+    // The files are read by a worker, the requests made meanwhile are recorded
+    // once they are loaded
+    _loading = true;
+    _loadTimer.start();
+    _loader.setFuture(QtConcurrent::run([basePath] { return _load(basePath); }));
+}
+
+void HistoryStore::close()
+{
+    // The modifications made while loading are recorded before closing, the
+    // loaded requests do not need to be indexed
+    _loader.waitForFinished();
+    if (_loading)
+    {
+        auto result = _loader.result();
+        _open(result);
+        _recordPending();
+    }
+
+    if (_indexCanceled != nullptr)
+        *_indexCanceled = true;
+    _indexer.waitForFinished();
+    _batchTimer.stop();
+    _loading = false;
+    _loadQueue.clear();
+    _pending.clear();
+
+    _compaction.waitForFinished();
+    _journal.close();
+
+    _blobs.close();
+    _references.clear();
+    _endpoints.clear();
+    _headerSizes.clear();
+    _memoryUsage.headers = 0;
+    _resident.clear();
+}
+
+void HistoryStore::touch(const RequestPtr & request)
+{
+    // Moves its bodies to the front of the least recently viewed ones
+    _resident.object(request->id);
+}
+
+void HistoryStore::setMemoryBudget(qint64 size)
+{
+    _resident.setMaxCost(static_cast<int>(qBound<qint64>(0, size, std::numeric_limits<int>::max())));
+    emit statisticsChanged();
+}
+
+const HistoryStore::MemoryUsage & HistoryStore::memoryUsage() const
+{
+    _memoryUsage.residentBodies = _resident.totalCost();
+    _memoryUsage.cachedBodies   = _blobs.cacheSize();
+    _memoryUsage.index          = _index.memoryUsage();
+    return _memoryUsage;
+}
+
+bool HistoryStore::contains(const RequestPtr & request) const
+{
+    if (_index.contains(request))
+        return true;
+
+    for (const auto & operation : _pending)
+        if (operation.second == request)
+            return true;
+    return false;
+}
+
+void HistoryStore::recordAdded(const RequestPtr & request)
+{
+    if (_isPending(Operation::Add, request))
+        return ;
+
+    if (request->id == 0)
+        request->id = _nextId++;
+
+    ++_liveCount;
+    _append(Operation::Add, request->id, _serialize(request));
+    _track(request);
+    _index.insert(request);
+    emit statisticsChanged();
+}
+
+void HistoryStore::recordsAdded(const QVector<RequestPtr> & requests)
+{
+    if (_loading)
+    {
+        for (const auto & request : requests)
+            _isPending(Operation::Add, request);
+        return ;
+    }
+
+    // The records are flushed, the index updated and the statistics notified
+    // once for all the requests
+    QVector<QPair<quint64, QByteArray>> records;
+    SearchIndex::Entries                texts;
+    records.reserve(requests.size());
+    texts.reserve(requests.size());
+    for (const auto & request : requests)
+    {
+        if (request->id == 0)
+            request->id = _nextId++;
+        records.push_back(qMakePair(request->id, _serialize(request)));
+        texts.insert(request->id, SearchIndex::entry(*request));
+        _track(request);
+    }
+
+    _liveCount += requests.size();
+    _append(Operation::Add, records);
+    _index.insert(requests);
+    _index.insertTexts(texts);
+    emit statisticsChanged();
+}
+
+void HistoryStore::recordUpdated(const RequestPtr & request)
+{
+    if (_isPending(Operation::Update, request))
+        return ;
+
+    _append(Operation::Update, request->id, _serialize(request));
+    _track(request);
+    _index.insert(request);
+    emit statisticsChanged();
+}
+
+void HistoryStore::recordDisplayFormatChanged(const RequestPtr & request)
+{
+    if (_isPending(Operation::DisplayFormat, request))
+        return ;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    setupStream(out);
+    out << request->displayFormat;
+
+    _append(Operation::DisplayFormat, request->id, payload);
+}
+
+void HistoryStore::recordRemoved(const RequestPtr & request)
+{
+    if (_isPending(Operation::Remove, request))
+        return ;
+
+    --_liveCount;
+    _append(Operation::Remove, request->id);
+    _untrack(request->id);
+    _index.remove(request->id);
+    emit statisticsChanged();
+}
+
+void HistoryStore::recordsRemoved(const QVector<RequestPtr> & requests)
+{
+    if (_loading)
+    {
+        for (const auto & request : requests)
+            _isPending(Operation::Remove, request);
+        return ;
+    }
+
+    // The records are flushed and the index updated once for all the requests
+    QVector<quint64> ids;
+    ids.reserve(requests.size());
+    for (const auto & request : requests)
+    {
+        ids.push_back(request->id);
+        _untrack(request->id);
+    }
+
+    _liveCount -= requests.size();
+    _append(Operation::Remove, ids);
+    _index.remove(ids);
+    emit statisticsChanged();
+}
+
+void HistoryStore::recordCleared()
+{
+    if (_isPending(Operation::Clear, nullptr))
+        return ;
+
+    // The requests not loaded yet are cleared as well
+    _loadQueue.clear();
+    _liveCount = 0;
+    _append(Operation::Clear, 0);
+    _index.clear();
+
+    for (const auto & references : _references)
+    {
+        _blobs.release(references.first);
+        _blobs.release(references.second);
+    }
+    _references.clear();
+    _endpoints.clear();
+    _headerSizes.clear();
+    _memoryUsage.headers = 0;
+    _resident.clear();
+    emit statisticsChanged();
+}
+
+void HistoryStore::_open(LoadResult & result)
+{
+    auto & entries = result.entries;
+    _nextId = result.maxId + 1;
+
+    _blobs.open(_basePath);
+    for (const auto & request : entries)
+    {
+        _blobs.attach(request->content);
+        _blobs.attach(request->responseContent);
+    }
+    _blobs.removeUnusedFiles();
+
+    // Bodies loaded from a previous file format are moved into a body file and
+    // the whole history is written again in the current format
+    auto migrate          = false;
+    auto migrationFailed  = false;
+    for (const auto & request : entries)
+        for (auto body : {&request->content, &request->responseContent})
+            if (!body->isStored() && body->isResident() && !body->isEmpty())
+            {
+                migrate = true;
+                migrationFailed |= !_blobs.store(*body);
+            }
+
+    if (migrate)
+    {
+        if (migrationFailed || !_writeBase(baseFilename(_basePath), entries))
+        {
+            qWarning("Unable to migrate the history at '%s'", qPrintable(_basePath));
+            return ;
+        }
+
+        QFile::remove(oldFilename(_basePath));
+        QFile::remove(journalFilename(_basePath));
+        QFile::remove(legacyFilename(_basePath));
+        result.journalInfo = ReplayInfo();
+    }
+
+    for (const auto & request : entries)
+        _track(request);
+    emit statisticsChanged();
+
+    _liveCount      = entries.size();
+    _journalRecords = result.journalInfo.recordCount;
+    _nextCompaction = qMax(compactionThreshold, 2 * _liveCount);
+
+    if (!_openJournal(result.journalInfo.validSize))
+        return ;
+
+    if (QFile::exists(oldFilename(_basePath)))
+        _startCompaction(false);
+    // The records appended to a journal are read with the version of its
+    // header, so a journal written by a previous version is rotated first
+    else if (_journalRecords >= _nextCompaction ||
+             (_journalRecords > 0 && result.journalInfo.version < journalVersion))
+        _startCompaction(true);
+}
+
+void HistoryStore::_onLoaded()
+{
+    if (!_loading)
+        return ; // Closed while loading
+
+    auto result = _loader.result();
+    _open(result);
+
+    // The most recent requests are displayed first
+    _loadQueue.reserve(result.entries.size());
+    for (const auto & request : result.entries)
+        _loadQueue.push_back(request);
+    std::sort(_loadQueue.begin(), _loadQueue.end(), [](const RequestPtr & r1, const RequestPtr & r2)
+    { return r1->date > r2->date; });
+    _loadBatchSize = Constants::historyBatchSize;
+
+    // The worker reads copies of the requests, their bodies are not shared
+    QVector<Request> requests;
+    requests.reserve(result.entries.size());
+    for (const auto & request : result.entries)
+        requests.push_back(*request);
+    const auto basePath = _basePath;
+    const auto canceled = std::make_shared<std::atomic<bool>>(false);
+    _indexCanceled = canceled;
+    _indexer.setFuture(QtConcurrent::run([basePath, requests, canceled]
+    { return _indexTexts(basePath, requests, canceled.get()); }));
+
+    _recordPending();
+
+    _loadNextBatch();
+}
+
+void HistoryStore::_recordPending()
+{
+    // The modifications made while loading are recorded in their order, the
+    // consecutive additions at once
+    const auto pending = _pending;
+    _pending.clear();
+    _loading = false;
+
+    QVector<RequestPtr> added;
+    QVector<RequestPtr> recorded;
+    for (const auto & operation : pending)
+    {
+        if (operation.first != Operation::Add && !added.isEmpty())
+        {
+            recordsAdded(added);
+            added.clear();
+        }
+
+        switch (operation.first)
+        {
+            case Operation::Add:           added.push_back(operation.second);            break;
+            case Operation::Update:        recordUpdated(operation.second);              break;
+            case Operation::Remove:        recordRemoved(operation.second);              break;
+            case Operation::Clear:         recordCleared();                              break;
+            case Operation::DisplayFormat: recordDisplayFormatChanged(operation.second); break;
+        }
+
+        if (operation.first == Operation::Add || operation.first == Operation::Update)
+            recorded.push_back(operation.second);
+    }
+    if (!added.isEmpty())
+        recordsAdded(added);
+
+    // The view could not display them until now, the removed ones are skipped
+    QVector<RequestPtr> requests;
+    QSet<quint64>       ids;
+    for (const auto & request : recorded)
+        if (_index.contains(request) && !ids.contains(request->id))
+        {
+            ids.insert(request->id);
+            requests.push_back(request);
+        }
+    if (!requests.isEmpty())
+        emit requestsRecorded(requests);
+}
+
+void HistoryStore::_loadNextBatch()
+{
+    if (_loadQueue.isEmpty())
+    {
+        _insertTexts();
+        emit loadFinished();
+        return ;
+    }
+
+    // The batches grow so the first one is displayed quickly and the whole
+    // history does not take too many refreshes
+    const auto batch = _loadQueue.mid(0, qMin(_loadBatchSize, _loadQueue.size()));
+    _index.insert(batch);
+    _loadQueue.remove(0, batch.size());
+    _loadBatchSize *= 2;
+    emit requestsLoaded(batch);
+    emit statisticsChanged();
+
+    _batchTimer.start();
+}
+
+void HistoryStore::_insertTexts()
+{
+    // Only once every loaded request is in the index, a request removed
+    // meanwhile is skipped
+    if (_indexCanceled == nullptr || *_indexCanceled || !_indexer.isFinished() || !_loadQueue.isEmpty())
+        return ;
+
+    _index.insertTexts(_indexer.result());
+    _indexCanceled.reset();
+    emit textsIndexed();
+}
+
+bool HistoryStore::_isPending(Operation operation, const RequestPtr & request)
+{
+    if (!_loading)
+        return false;
+
+    _pending.push_back(qMakePair(operation, request));
+    return true;
+}
+
+bool HistoryStore::_openJournal(qint64 validSize)
+{
+    _journal.setFileName(journalFilename(_basePath));
+    if (!_journal.open(QIODevice::ReadWrite))
+    {
+        qWarning("Unable to open/create file '%s': %s", qPrintable(_journal.fileName()),
+                 qPrintable(_journal.errorString()));
+        return false;
+    }
+
+    if (validSize <= 0)
+    {
+        _journal.resize(0);
+        QDataStream out(&_journal);
+        setupStream(out);
+        writeHeader(out);
+    }
+    else
+    {
+        // Drop a record that may have been partially written by a crash
+        _journal.resize(validSize);
+        _journal.seek(validSize);
+    }
+
+    _journal.flush();
+    return true;
+}
+
+void HistoryStore::_append(Operation operation, quint64 id, const QByteArray & payload)
+{
+    _append(operation, QVector<quint64>{id}, payload);
+}
+
+void HistoryStore::_append(Operation operation, const QVector<quint64> & ids, const QByteArray & payload)
+{
+    QVector<QPair<quint64, QByteArray>> records;
+    records.reserve(ids.size());
+    for (const auto & id : ids)
+        records.push_back(qMakePair(id, payload));
+    _append(operation, records);
+}
+
+void HistoryStore::_append(Operation operation, const QVector<QPair<quint64, QByteArray>> & records)
+{
+    if (!_journal.isOpen() || records.isEmpty())
+        return ;
+
+    QDataStream out(&_journal);
+    setupStream(out);
+    for (const auto & record : records)
+        writeRecord(out, static_cast<quint8>(operation), record.first, record.second);
+    _journal.flush();
+
+    _journalRecords += records.size();
+    if (_journalRecords >= _nextCompaction)
+        _startCompaction(true);
+}
+
+QByteArray HistoryStore::_serialize(const RequestPtr & request)
+{
+    if (isOpen())
+    {
+        _blobs.store(request->content);
+        _blobs.store(request->responseContent);
+    }
+
+    return serialize(*request);
+}
+
+void HistoryStore::_startCompaction(bool rotate)
+{
+    if (_compaction.isRunning())
+        return ;
+
+    // The old journal is only replaced once it has been merged into the base
+    if (rotate && !QFile::exists(oldFilename(_basePath)))
+    {
+        _journal.close();
+        if (QFile::rename(journalFilename(_basePath), oldFilename(_basePath)))
+        {
+            _journalRecords = 0;
+            _openJournal(-1);
+
+            // The bodies referenced by the old journal are no longer appended to
+            // so the compaction can safely read them
+            _blobs.seal();
+        }
+        else
+        {
+            qWarning("Unable to rotate the history journal '%s'", qPrintable(_journal.fileName()));
+            _openJournal(QFileInfo(_journal.fileName()).size());
+        }
+    }
+
+    _nextCompaction = _journalRecords + qMax(compactionThreshold, 2 * _liveCount);
+    if (!QFile::exists(oldFilename(_basePath)))
+        return ;
+
+    const auto basePath         = _basePath;
+    const auto vacuumGeneration = _blobs.allocateGeneration();
+    _compaction = QtConcurrent::run([basePath, vacuumGeneration]
+    { return _compact(basePath, vacuumGeneration); });
+}
+
+void HistoryStore::_track(const RequestPtr & request)
+{
+    _untrack(request->id);
+
+    const auto references = qMakePair(BlobStore::reference(request->content),
+                                      BlobStore::reference(request->responseContent));
+    _blobs.acquire(references.first);
+    _blobs.acquire(references.second);
+    _references.insert(request->id, references);
+    _endpoints.add(*request);
+
+    const auto headersSize = _headersSize(*request);
+    _headerSizes.insert(request->id, headersSize);
+    _memoryUsage.headers += headersSize;
+
+    // The bodies kept in memory once written are only held while they fit in
+    // the budget, a body larger than the budget is evicted right away
+    qint64 residentSize = 0;
+    for (auto body : {&request->content, &request->responseContent})
+        if (body->isResident() && body->isStored())
+            residentSize += body->size();
+    if (residentSize > 0)
+        _resident.insert(request->id, new ResidentBodies(request),
+                         static_cast<int>(qMin(residentSize, Body::maxArraySize)));
+}
+
+void HistoryStore::_untrack(quint64 id)
+{
+    _endpoints.remove(id);
+    _memoryUsage.headers -= _headerSizes.take(id);
+
+    // Not evicted, the request may be tracked again right away
+    const auto resident = _resident.take(id);
+    if (resident != nullptr)
+        resident->request.reset();
+    delete resident;
+
+    const auto itr = _references.find(id);
+    if (itr == _references.end())
+        return ;
+
+    _blobs.release(itr->first);
+    _blobs.release(itr->second);
+    _references.erase(itr);
+}
+
+HistoryStore::ResidentBodies::~ResidentBodies()
+{
+    // Read back from their file, through its memory mapping, when displayed
+    if (request == nullptr)
+        return ;
+
+    request->content.evict();
+    request->responseContent.evict();
+}
+
+int HistoryStore::_headersSize(const Request & request)
+{
+    auto size = request.url().toEncoded().size() + request.method.size() + request.reasonPhrase.size() * 2;
+    for (const auto & header : request.requestHeaders())
+        size += header.first.size() + header.second.size();
+    for (const auto & header : request.responseHeaders)
+        size += header.first.size() + header.second.size();
+    return size;
+}
+
+HistoryStore::LoadResult HistoryStore::_load(const QString & basePath)
+{
+    LoadResult result;
+    if (!QFile::exists(baseFilename(basePath)) && !QFile::exists(journalFilename(basePath)) &&
+        QFile::exists(legacyFilename(basePath)))
+        _loadLegacy(legacyFilename(basePath), result.entries);
+    else
+    {
+        // A left over old journal means that the last compaction did not
+        // complete, it has to be replayed between the base and the journal
+        ReplayInfo baseInfo;
+        ReplayInfo oldInfo;
+        _replay(baseFilename(basePath),    result.entries, &baseInfo);
+        _replay(oldFilename(basePath),     result.entries, &oldInfo);
+        _replay(journalFilename(basePath), result.entries, &result.journalInfo);
+        result.maxId = qMax(baseInfo.maxId, qMax(oldInfo.maxId, result.journalInfo.maxId));
+    }
+
+    if (!result.entries.isEmpty())
+        result.maxId = qMax(result.maxId, result.entries.lastKey());
+    return result;
+}
+
+SearchIndex::Entries HistoryStore::_indexTexts(const QString & basePath, QVector<Request> requests,
+                                               const std::atomic<bool> * canceled)
+{
+    // The bodies are read through mappings of the worker, the files of the
+    // store are used by the GUI thread
+    QHash<quint32, BodyFilePtr> files;
+    SearchIndex::Entries entries;
+    entries.reserve(requests.size());
+    for (auto & request : requests)
+    {
+        if (*canceled)
+            return {};
+
+        auto & body = request.responseContent;
+        if (body.isStored() && !body.isResident())
+        {
+            const auto generation = body.generation();
+            if (!files.contains(generation))
+            {
+                auto file = std::make_shared<BodyFile>(BlobStore::filename(basePath, generation), generation);
+                files.insert(generation, file->open(false) ? file : nullptr);
+            }
+            body.attach(files.value(generation));
+        }
+
+        entries.insert(request.id, SearchIndex::entry(request));
+        body = Body();
+    }
+
+    return entries;
+}
+
+bool HistoryStore::_replay(const QString & filename, Entries & entries, ReplayInfo * info)
+{
+    QFile file(filename);
+    if (!file.exists())
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning("Unable to open file '%s': %s", qPrintable(filename), qPrintable(file.errorString()));
+        return false;
+    }
+
+    QDataStream in(&file);
+    setupStream(in);
+
+    quint32 version = 0;
+    if (!readHeader(in, version))
+    {
+        qWarning("File '%s' is not a valid history journal", qPrintable(filename));
+        return false;
+    }
+
+    ReplayInfo dummy;
+    ReplayInfo & replayInfo = info == nullptr ? dummy : *info;
+    replayInfo.validSize = file.pos();
+    replayInfo.version   = version;
+
+    while (!in.atEnd())
+    {
+        quint8     operation = 0;
+        quint64    id        = 0;
+        QByteArray payload;
+        quint16    payloadChecksum = 0;
+        in >> operation >> id >> payload >> payloadChecksum;
+        if (in.status() != QDataStream::Ok || payloadChecksum != checksum(payload))
+        {
+            qWarning("Corrupted record at offset %lld in '%s', ignoring the rest of the file",
+                     replayInfo.validSize, qPrintable(filename));
+            break;
+        }
+
+        QDataStream stream(payload);
+        setupStream(stream);
+        switch (static_cast<Operation>(operation))
+        {
+            case Operation::Add:
+            case Operation::Update:
+            {
+                // An update can arrive after the request has been removed
+                if (static_cast<Operation>(operation) == Operation::Update && !entries.contains(id))
+                    break;
+
+                // The first version of the journal stored the bodies in the records
+                auto request = std::make_shared<Request>();
+                if (version == 1)
+                    stream >> *request;
+                else
+                    readRequest(stream, *request, version);
+                request->id = id;
+                entries.insert(id, request);
+            }
+                break;
+            case Operation::Remove:
+                entries.remove(id);
+                break;
+            case Operation::Clear:
+                entries.clear();
+                break;
+            case Operation::DisplayFormat:
+            {
+                const auto request = entries.value(id);
+                if (request != nullptr)
+                    stream >> request->displayFormat;
+            }
+                break;
+        }
+
+        ++replayInfo.recordCount;
+        replayInfo.validSize = file.pos();
+        replayInfo.maxId     = qMax(replayInfo.maxId, id);
+    }
+
+    return true;
+}
+
+bool HistoryStore::_writeBase(const QString & filename, const Entries & entries)
+{
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning("Unable to open/create file '%s': %s", qPrintable(filename), qPrintable(file.errorString()));
+        return false;
+    }
+
+    QDataStream out(&file);
+    setupStream(out);
+    writeHeader(out);
+    for (const auto & request : entries)
+        writeRecord(out, static_cast<quint8>(Operation::Add), request->id, serialize(*request));
+
+    if (!file.commit())
+    {
+        qWarning("Unable to write file '%s': %s", qPrintable(filename), qPrintable(file.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+bool HistoryStore::_compact(const QString & basePath, quint32 vacuumGeneration)
+{
+    Entries entries;
+    if (!_replay(baseFilename(basePath), entries) || !_replay(oldFilename(basePath), entries))
+        return false;
+
+    QVector<Body *> bodies;
+    bodies.reserve(entries.size() * 2);
+    for (const auto & request : entries)
+    {
+        bodies.push_back(&request->content);
+        bodies.push_back(&request->responseContent);
+    }
+
+    if (!BlobStore::vacuum(basePath, bodies, vacuumGeneration) ||
+        !_writeBase(baseFilename(basePath), entries))
+        return false;
+
+    return QFile::remove(oldFilename(basePath));
+}
+
+bool HistoryStore::_loadLegacy(const QString & filename, Entries & entries)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    setupStream(in);
+
+    QVector<RequestPtr> requests;
+    in >> requests;
+
+    quint64 id = 0;
+    for (const auto & request : requests)
+    {
+        request->id = ++id;
+        entries.insert(id, request);
+    }
+
+    return in.status() == QDataStream::Ok;
+}
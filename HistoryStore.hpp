@@ -0,0 +1,202 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QObject>
+#include <QFile>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QCache>
+#include <QMap>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+#include "BlobStore.hpp"
+#include "HistoryIndex.hpp"
+#include "EndpointStatistics.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <atomic>
+#include <memory>
+
+// Append-only journal of the history modifications.
+//
+// The history is persisted in two files: a base file holding one record per
+// request and a journal to which every modification is appended as soon as it
+// happens. When the journal grows too much it is rotated and merged into the
+// base file by a background task, so the cost of a write only depends on the
+// size of the change and a crash loses at most the record being written.
+//
+// The records only hold the metadata of the requests, the bodies are written
+// in a BlobStore and the records reference them by location. Loading the
+// history therefore never reads a body: they are mapped in memory and only
+// read when displayed.
+//
+// The requests are kept in a HistoryIndex, which is maintained even when no
+// file is open so the history can be browsed the same way, and their latencies
+// in EndpointStatistics.
+//
+// The bodies recorded during the session stay in memory once written, within
+// a memory budget: past it, the bodies of the least recently viewed requests
+// are evicted and read back from their file when displayed again.
+//
+// Opening a history does not block: its files are replayed by a worker, then
+// the requests are added to the index by growing batches, most recent first,
+// one per event loop iteration. The modifications made before the files are
+// replayed are recorded once they are, then reported by requestsRecorded(). The texts of the loaded requests are
+// indexed by another worker, which reads their bodies, and added to the index
+// once all the requests are.
+class HistoryStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Entries = QMap<quint64, RequestPtr>;
+
+    // Approximate memory used by the history, in bytes
+    struct MemoryUsage
+    {
+        qint64 residentBodies = 0;
+        qint64 cachedBodies   = 0;
+        qint64 headers        = 0;
+        qint64 index          = 0;
+    };
+
+public:
+    explicit HistoryStore(QObject * parent = nullptr);
+    ~HistoryStore() override;
+
+    void open(const QString & basePath);
+    void close();
+    bool isOpen() const      { return _journal.isOpen(); }
+    bool isLoading() const   { return _loading || !_loadQueue.isEmpty(); }
+    qint64 loadTime() const  { return _loadTimer.elapsed(); }
+
+    // Also true for the requests recorded while loading
+    bool contains(const RequestPtr & request) const;
+
+    void recordAdded(const RequestPtr & request);
+    void recordsAdded(const QVector<RequestPtr> & requests);
+    void recordUpdated(const RequestPtr & request);
+    void recordDisplayFormatChanged(const RequestPtr & request);
+    void recordRemoved(const RequestPtr & request);
+    void recordsRemoved(const QVector<RequestPtr> & requests);
+    void recordCleared();
+
+    const HistoryIndex & index() const               { return _index; }
+    const EndpointStatistics & endpoints() const     { return _endpoints; }
+    const BlobStore::Statistics & statistics() const { return _blobs.statistics(); }
+    void setCompressionEnabled(bool value)           { _blobs.setCompressionEnabled(value); }
+
+    void touch(const RequestPtr & request);
+    void setMemoryBudget(qint64 size);
+    qint64 memoryBudget() const             { return _resident.maxCost(); }
+    const MemoryUsage & memoryUsage() const;
+
+signals:
+    void statisticsChanged();
+    void requestsLoaded(const QVector<RequestPtr> & requests);
+    // Added or updated while the files were replayed, not in the index until then
+    void requestsRecorded(const QVector<RequestPtr> & requests);
+    void loadFinished();
+    void textsIndexed();
+
+private:
+    enum class Operation : quint8
+    {
+        Add           = 1,
+        Update        = 2,
+        Remove        = 3,
+        Clear         = 4,
+        DisplayFormat = 5
+    };
+
+    struct ReplayInfo
+    {
+        int     recordCount = 0;
+        qint64  validSize   = -1;
+        quint64 maxId       = 0;
+        quint32 version     = 0;
+    };
+
+    struct ResidentBodies
+    {
+        explicit ResidentBodies(const RequestPtr & request) : request(request) {}
+        ~ResidentBodies();
+
+        RequestPtr request;
+    };
+
+    struct LoadResult
+    {
+        Entries    entries;
+        ReplayInfo journalInfo;
+        quint64    maxId = 0;
+    };
+
+    void _open(LoadResult & result);
+    void _onLoaded();
+    void _recordPending();
+    void _loadNextBatch();
+    void _insertTexts();
+    bool _isPending(Operation operation, const RequestPtr & request);
+
+    bool _openJournal(qint64 validSize);
+    void _append(Operation operation, quint64 id, const QByteArray & payload = {});
+    void _append(Operation operation, const QVector<quint64> & ids, const QByteArray & payload = {});
+    void _append(Operation operation, const QVector<QPair<quint64, QByteArray>> & records);
+    QByteArray _serialize(const RequestPtr & request);
+    void _startCompaction(bool rotate);
+
+    void _track(const RequestPtr & request);
+    void _untrack(quint64 id);
+
+private:
+    static int _headersSize(const Request & request);
+    static LoadResult _load(const QString & basePath);
+    static SearchIndex::Entries _indexTexts(const QString & basePath, QVector<Request> requests,
+                                            const std::atomic<bool> * canceled);
+    static bool _replay(const QString & filename, Entries & entries,
+                        ReplayInfo * info = nullptr);
+    static bool _writeBase(const QString & filename, const Entries & entries);
+    static bool _compact(const QString & basePath, quint32 vacuumGeneration);
+    static bool _loadLegacy(const QString & filename, Entries & entries);
+
+private:
+    QString       _basePath;
+    QFile         _journal;
+    quint64       _nextId;
+    int           _liveCount;
+    int           _journalRecords;
+    int           _nextCompaction;
+    QFuture<bool> _compaction;
+
+    QFutureWatcher<LoadResult>              _loader;
+    QElapsedTimer                           _loadTimer;
+    QTimer                                  _batchTimer;
+    bool                                    _loading;
+    QVector<RequestPtr>                     _loadQueue;     // Most recent first
+    int                                     _loadBatchSize;
+    QVector<QPair<Operation, RequestPtr>>   _pending;
+
+    QFutureWatcher<SearchIndex::Entries>    _indexer;
+    std::shared_ptr<std::atomic<bool>>      _indexCanceled;
+
+    HistoryIndex                                                      _index;
+    EndpointStatistics                                                _endpoints;
+    QCache<quint64, ResidentBodies>                                   _resident;
+    QHash<quint64, int>                                               _headerSizes;
+    mutable MemoryUsage                                               _memoryUsage;
+    BlobStore                                                         _blobs;
+    QHash<quint64, QPair<BlobStore::Reference, BlobStore::Reference>> _references;
+};
@@ -11,7 +11,10 @@
 
 // Project includes ------------------------------------------------------------
 #include "Constants.hpp"
-#include "DateTimeItem.hpp"
+#include "HistoryStore.hpp"
+#include "HistoryModel.hpp"
+#include "EndpointStatsDialog.hpp"
+#include "RequestExport.hpp"
 
 // Qt includes -----------------------------------------------------------------
 #include <QKeyEvent>
@@ -21,22 +24,44 @@
 #include <QWindow>
 #include <QMimeData>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QDir>
+
+// C++ standard library includes -----------------------------------------------
+#include <algorithm>
 
 HistoryViewer::HistoryViewer(QWidget * parent) :
-    QWidget(parent)
+    QWidget(parent),
+    _store(new HistoryStore(this)),
+    _model(new HistoryModel(_store->index(), this)),
+    _maxHistorySize(Constants::maxHistorySize)
 {
-    _requests.reserve(Constants::maxHistorySize);
-
     _ui.setupUi(this);
-    _ui.tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
-    _ui.tableWidget->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    _ui.tableView->setModel(_model);
+    _ui.tableView->sortByColumn(HistoryModel::Date, Qt::DescendingOrder);
+    _ui.tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _ui.tableView->horizontalHeader()->setSectionResizeMode(HistoryModel::Url, QHeaderView::Stretch);
 
-    QObject::connect(_ui.tableWidget, &QTableWidget::itemSelectionChanged,
+    QObject::connect(_ui.tableView->selectionModel(), &QItemSelectionModel::selectionChanged,
                      this, &HistoryViewer::_itemSelectionChanged);
 
     QObject::connect(qApp, &QGuiApplication::focusWindowChanged,
                      this, &HistoryViewer::_onWindowFocusChanged);
 
+    QObject::connect(_store, &HistoryStore::statisticsChanged,
+                     this, &HistoryViewer::_onStoreStatisticsChanged);
+    QObject::connect(_store, &HistoryStore::requestsLoaded,
+                     this, &HistoryViewer::_onRequestsLoaded);
+    QObject::connect(_store, &HistoryStore::requestsRecorded,
+                     this, &HistoryViewer::_onRequestsRecorded);
+    QObject::connect(_store, &HistoryStore::loadFinished,
+                     this, &HistoryViewer::_onLoadFinished);
+    QObject::connect(_store, &HistoryStore::textsIndexed,
+                     this, &HistoryViewer::_onTextsIndexed);
+
     auto clipboard = QGuiApplication::clipboard();
     QObject::connect(clipboard, &QClipboard::changed,
                      this, &HistoryViewer::_onClipboardChanged);
@@ -50,51 +75,93 @@ HistoryViewer::HistoryViewer(QWidget * parent) :
     // Copy to clipboard button
     QObject::connect(_ui.pbCopyClipboard, &QPushButton::clicked,
                      this, &HistoryViewer::_onPbCopyClipboardClicked);
+    // Export/import buttons
+    QObject::connect(_ui.pbExport, &QPushButton::clicked,
+                     this, &HistoryViewer::_onPbExportClicked);
+    QObject::connect(_ui.pbImport, &QPushButton::clicked,
+                     this, &HistoryViewer::_onPbImportClicked);
+    // Statistics button
+    QObject::connect(_ui.pbStatistics, &QPushButton::clicked,
+                     this, &HistoryViewer::_onPbStatisticsClicked);
+
+    // Filters
+    for (auto lineEdit : {_ui.leSearch, _ui.leHostFilter, _ui.leMethodFilter, _ui.leStatusFilter})
+        QObject::connect(lineEdit, &QLineEdit::textChanged,
+                         this, &HistoryViewer::_onFilterChanged);
 }
 
 bool HistoryViewer::hasRequest(RequestPtr request) const
 {
-    return _requests.contains(request);
+    return _store->contains(request);
 }
 
 void HistoryViewer::updateRequest(RequestPtr request)
 {
-    const auto row = _getRowForRequest(request.get());
-    _fillTableRow(row, request);
+    if (!hasRequest(request))
+        return ; // Removed from the history while waiting for the response
 
-    _ui.tableWidget->viewport()->update();
+    _store->recordUpdated(request);
+    _model->requestUpdated(request);
+}
+
+void HistoryViewer::updateRequestDisplayFormat(RequestPtr request)
+{
+    if (!hasRequest(request))
+        return ;
+
+    _store->recordDisplayFormatChanged(request);
 }
 
 void HistoryViewer::addRequest(RequestPtr request)
 {
-    if (_requests.size() >= Constants::maxHistorySize)
-    {
-        QObject::disconnect(_ui.tableWidget, &QTableWidget::itemSelectionChanged,
-                            this, &HistoryViewer::_itemSelectionChanged);
-        const auto rowToRemove = _ui.tableWidget->rowCount() - 1;
-        const auto requestIdx  = _getRequestIdxForItem(_ui.tableWidget->item(rowToRemove, 0));
-        _ui.tableWidget->removeRow(rowToRemove);
-        _requests.remove(requestIdx);
-        QObject::connect(_ui.tableWidget, &QTableWidget::itemSelectionChanged,
-                            this, &HistoryViewer::_itemSelectionChanged);
-    }
+    _evict(1);
+    _store->recordAdded(request);
+    _model->requestAdded(request);
+    _updateCount();
+
+    const auto row = _model->row(request);
+    if (row != -1)
+        _ui.tableView->selectRow(row);
+}
 
-    _addRequestToTable(request);
-    _requests.push_back(request);
+void HistoryViewer::addRequests(const QVector<RequestPtr> & requests)
+{
+    if (requests.isEmpty())
+        return ;
 
-    _ui.tableWidget->selectRow(0);
+    // Only the last requests of a batch larger than the history are kept
+    const auto count = qMin(requests.size(), _maxHistorySize);
+    const auto added = requests.mid(requests.size() - count);
+    _evict(count, false);
+    _store->recordsAdded(added);
+    _displayAdded(added);
 }
 
-void HistoryViewer::load(QDataStream & in)
+QVector<RequestPtr> HistoryViewer::recentRequests(int count) const
 {
-    in >> _requests;
-    for (const auto & request : _requests)
-        _addRequestToTable(request);
+    return _store->index().find({}, 0, count);
 }
 
-void HistoryViewer::save(QDataStream & out) const
+void HistoryViewer::setCompressionEnabled(bool value)
 {
-    out << _requests;
+    _store->setCompressionEnabled(value);
+}
+
+void HistoryViewer::setMemoryBudget(qint64 size)
+{
+    _store->setMemoryBudget(size);
+}
+
+void HistoryViewer::openStore(const QString & basePath)
+{
+    _loadedCount = 0;
+    _store->open(basePath);
+    _refresh();
+}
+
+void HistoryViewer::closeStore()
+{
+    _store->close();
 }
 
 void HistoryViewer::keyPressEvent(QKeyEvent * event)
@@ -105,96 +172,94 @@ void HistoryViewer::keyPressEvent(QKeyEvent * event)
     _ui.pbDelete->click();
 }
 
-void HistoryViewer::_addRequestToTable(const RequestPtr request)
+void HistoryViewer::_refresh()
 {
-    const int row = _ui.tableWidget->rowCount();
-    _ui.tableWidget->setRowCount(row + 1);
-    _fillTableRow(row, request);
+    _model->refresh();
+    _updateCount();
+    _itemSelectionChanged();
+}
 
-    _ui.pbClear->setEnabled(true);
-    _ui.tableWidget->sortItems(3, Qt::DescendingOrder);
-    _ui.tableWidget->viewport()->update();
+void HistoryViewer::_updateCount()
+{
+    const auto count = _model->rowCount();
+    _ui.lCount->setText(count == 0 ? QString("No request") :
+                                     QString("%1 request%2").arg(count).arg(count > 1 ? "s" : ""));
+    _ui.pbClear->setEnabled(_store->index().size() > 0);
 }
 
-void HistoryViewer::_fillTableRow(int row, const RequestPtr request)
+void HistoryViewer::_evict(int count, bool updateRows)
 {
-    _ui.tableWidget->setItem(row, 0, _createTableItem(request->method.constData()));
-    _ui.tableWidget->setItem(row, 1, _createTableItem(request->url().toString()));
-    _ui.tableWidget->setItem(row, 2, _createTableItem(QString("%1 %2").arg(request->statusCode)
-                                                       .arg(request->reasonPhrase)));
-    _ui.tableWidget->setItem(row, 3, _createTableItem(request->date.toString(DateTimeItem::dateFormat), true));
-    _ui.tableWidget->setItem(row, 4, _createTableItem(_formatSize(request->responseContent.size())));
-    _ui.tableWidget->setItem(row, 5, _createTableItem(QString("%1 ms").arg(request->elapsedTime)));
+    // The oldest requests are dropped once the history is full, which is only
+    // known once it is loaded
+    const auto excess = _store->index().size() + count - _maxHistorySize;
+    if (_store->isLoading() || excess <= 0)
+        return ;
 
-    _ui.tableWidget->item(row, 0)->setData(Qt::UserRole, QVariant::fromValue(request.get()));
+    const auto evicted = _store->index().oldest(excess);
+    if (updateRows)
+        _model->removeRequests(evicted);
+    _store->recordsRemoved(evicted);
 }
 
-int HistoryViewer::_getRequestIdxForItem(const QTableWidgetItem * item) const
+QVector<int> HistoryViewer::_getSelectedRows() const
 {
-    const auto request = _getRequestForItem(item);
-    for (int i = 0; i < _requests.size(); ++i)
-        if (_requests.at(i).get() == request)
-            return i;
-    return -1;
+    const auto selectedIndexes = _ui.tableView->selectionModel()->selectedRows();
+    QVector<int> rows;
+    rows.reserve(selectedIndexes.size());
+    for (const auto & index : selectedIndexes)
+        rows.push_back(index.row());
+
+    std::sort(rows.begin(), rows.end());
+    return rows;
 }
 
-Request * HistoryViewer::_getRequestForItem(const QTableWidgetItem * item) const
+QVector<RequestPtr> HistoryViewer::_getSelectedRequests() const
 {
-    const auto firstItem = item->column() == 0 ? item : _ui.tableWidget->item(item->row(), 0);
-    return qvariant_cast<Request *>(firstItem->data(Qt::UserRole));
+    const auto selectedRows = _getSelectedRows();
+    QVector<RequestPtr> requests;
+    requests.reserve(selectedRows.size());
+    for (const auto & row : selectedRows)
+        requests.push_back(_model->request(row));
+    return requests;
 }
 
-int HistoryViewer::_getRowForRequest(const Request * request) const
+void HistoryViewer::_displayAdded(const QVector<RequestPtr> & requests)
 {
-    for (int row = 0; row < _ui.tableWidget->rowCount(); ++row)
+    // While loading the rows are not reset, and the requests recorded before
+    // the files are replayed are not in the index yet: they are displayed once
+    // they are, by _onRequestsRecorded()
+    if (_store->isLoading())
     {
-        const auto item = _ui.tableWidget->item(row, 0);
-        if (qvariant_cast<Request *>(item->data(Qt::UserRole)) == request)
-            return row;
+        _model->requestsAdded(requests);
+        _updateCount();
+        return ;
     }
 
-    return -1;
-}
-
-QVector<QTableWidgetItem *> HistoryViewer::_getUniqueItemPerSelectedRow() const
-{
-    auto selectedItems = QVector<QTableWidgetItem *>::fromList(_ui.tableWidget->selectedItems());
-    std::sort(selectedItems.begin(), selectedItems.end(),
-              [](const QTableWidgetItem * v1, const QTableWidgetItem * v2)
-    { return v1->row() < v2->row(); });
-
-    selectedItems.erase(std::unique(selectedItems.begin(), selectedItems.end(),
-                                    [](const QTableWidgetItem * v1, const QTableWidgetItem * v2)
-    { return v1->row() == v2->row(); }), selectedItems.end());
-    return selectedItems;
+    // The rows are only updated once for the whole batch
+    _refresh();
 }
 
 void HistoryViewer::_tryLoadRequestFromClipboard(QClipboard::Mode mode)
 {
     // Check clipboard info
-    auto clipboard = QGuiApplication::clipboard();
-    if (clipboard->mimeData(mode) == nullptr || !clipboard->mimeData(mode)->hasText())
-        return ;
-
-    const auto json = QJsonDocument::fromJson(clipboard->text(mode).toUtf8()).object();
-    if (json.isEmpty())
+    auto clipboard      = QGuiApplication::clipboard();
+    const auto mimeData = clipboard->mimeData(mode);
+    if (mimeData == nullptr)
         return ;
 
-    // Convert clipboard info into requests
-    std::vector<RequestPtr> requests;
-    const auto jsonRequests = json.value(Keys::requests).toArray();
-    requests.reserve(static_cast<std::size_t>(jsonRequests.size()));
-    for (const auto jsonRequest : jsonRequests)
+    // Convert clipboard info into requests, the binary format is preferred
+    QVector<RequestPtr> requests;
+    if (mimeData->hasFormat(Constants::binaryExportMimeType))
     {
-        requests.emplace_back(std::make_shared<Request>());
-        auto & request = requests.back();
-        request->fromJson(jsonRequest.toObject());
-
-        if (request->isNull())
-            requests.pop_back();
+        auto data = mimeData->data(Constants::binaryExportMimeType);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        requests = _requestsFromBinary(&buffer);
     }
+    else if (mimeData->hasText())
+        requests = _requestsFromJson(mimeData->text().toUtf8());
 
-    if (requests.empty())
+    if (requests.isEmpty())
         return ;
 
     // Ask the user if he want to import
@@ -204,104 +269,307 @@ void HistoryViewer::_tryLoadRequestFromClipboard(QClipboard::Mode mode)
     if (button != QMessageBox::Yes)
         return ;
 
-    // Add request to the table widget
-    for (const auto & request : requests)
-        addRequest(request);
+    _importRequests(requests);
+}
+
+void HistoryViewer::_importRequests(const QVector<RequestPtr> & requests)
+{
+    addRequests(requests);
+    _selectRequests(requests);
+}
 
+void HistoryViewer::_selectRequests(const QVector<RequestPtr> & requests)
+{
     // Select new row
-    std::vector<int> newRequestRows;
+    QItemSelection selection;
     for (const auto & request : requests)
-        newRequestRows.push_back(_getRowForRequest(request.get()));
+    {
+        const auto row = _model->row(request);
+        if (row != -1)
+            selection.select(_model->index(row, 0), _model->index(row, HistoryModel::ColumnCount - 1));
+    }
 
-    _ui.tableWidget->clearSelection();
-    for (const auto & row : newRequestRows)
-        _ui.tableWidget->setRangeSelected({row, 0, row, _ui.tableWidget->columnCount() - 1}, true);
+    _ui.tableView->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
 }
 
-QTableWidgetItem * HistoryViewer::_createTableItem(const QString & text, bool dateTime)
+QByteArray HistoryViewer::_requestsToJson(const QVector<RequestPtr> & requests)
 {
-    auto item = dateTime ? new DateTimeItem(text) : new QTableWidgetItem(text);
-    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
-    return item;
+    QJsonArray jsonRequests;
+    for (const auto & request : requests)
+        jsonRequests.append(request->toJson());
+
+    const auto json = QJsonObject{{Keys::requests, jsonRequests}};
+    return QJsonDocument(json).toJson();
 }
 
-QString HistoryViewer::_formatSize(qint32 size)
+QVector<RequestPtr> HistoryViewer::_requestsFromJson(const QByteArray & data)
 {
-    static const auto f = [](const int value, const int factor)
+    QVector<RequestPtr> requests;
+    const auto json = QJsonDocument::fromJson(data).object();
+    if (json.isEmpty())
+        return requests;
+
+    const auto jsonRequests = json.value(Keys::requests).toArray();
+    requests.reserve(jsonRequests.size());
+    for (const auto jsonRequest : jsonRequests)
     {
-        const auto val = (value % factor) / (factor / 10);
-        if (val == 0)
-            return QString::number(value / factor);
-        else
-            return QString("%1.%2").arg(value / factor).arg(val);
-    };
-
-    if (size < 1024)
-        return QString("%1 B").arg(size);
-    else if (size < 1024 * 1024)
-        return QString("%1 kB").arg(f(size, 1024));
-    else if (size < 1024 * 1024 * 1024)
-        return QString("%1 MB").arg(f(size , 1024 * 1024));
-    else
-        return QString("%1 GB").arg(f(size , 1024 * 1024 * 1024));
+        const auto request = std::make_shared<Request>();
+        request->fromJson(jsonRequest.toObject());
+
+        if (!request->isNull())
+            requests.push_back(request);
+    }
+
+    return requests;
+}
+
+QVector<RequestPtr> HistoryViewer::_requestsFromBinary(QIODevice * device)
+{
+    QVector<RequestPtr> requests;
+    RequestImporter importer(device);
+    while (!importer.atEnd())
+    {
+        const auto request = importer.read();
+        if (request != nullptr && !request->isNull())
+            requests.push_back(request);
+    }
+
+    return requests;
 }
 
 void HistoryViewer::_itemSelectionChanged()
 {
-    const auto areItemSelected = !_ui.tableWidget->selectedItems().isEmpty();
+    const auto areItemSelected = _ui.tableView->selectionModel()->hasSelection();
     _ui.pbDelete->setEnabled(areItemSelected);
     _ui.pbCopyClipboard->setEnabled(areItemSelected);
+    _ui.pbExport->setEnabled(areItemSelected);
 
     if (!areItemSelected)
         return ;
 
-    const auto idx = _getRequestIdxForItem(_ui.tableWidget->currentItem());
-    emit currentChanged(_requests.at(idx));
+    const auto request = _model->request(_ui.tableView->currentIndex().row());
+    if (request != nullptr)
+    {
+        _store->touch(request);
+        emit currentChanged(request);
+    }
 }
 
 void HistoryViewer::_onPbClearClicked()
 {
-    _ui.tableWidget->clearContents();
-    _ui.tableWidget->setRowCount(0);
-    _requests.clear();
-    _ui.pbClear->setEnabled(false);
+    _store->recordCleared();
+    _refresh();
 }
 
 void HistoryViewer::_onPbDeleteClicked()
 {
-    const auto selectedItems = _getUniqueItemPerSelectedRow();
-    for (const auto & item : selectedItems)
-    {
-        const auto idx = _getRequestIdxForItem(item);
-        _requests.removeAt(idx);
-
-        QObject::disconnect(_ui.tableWidget, &QTableWidget::itemSelectionChanged,
-                            this, &HistoryViewer::_itemSelectionChanged);
-        _ui.tableWidget->removeRow(item->row());
-        QObject::connect(_ui.tableWidget, &QTableWidget::itemSelectionChanged,
-                         this, &HistoryViewer::_itemSelectionChanged);
-    }
-
-    if (_ui.tableWidget->rowCount() == 0)
-        _ui.pbClear->setEnabled(false);
+    // The selection is only updated once all the rows are removed
+    const auto requests = _getSelectedRequests();
+    QObject::disconnect(_ui.tableView->selectionModel(), &QItemSelectionModel::selectionChanged,
+                        this, &HistoryViewer::_itemSelectionChanged);
+    _model->removeRequests(requests);
+    _store->recordsRemoved(requests);
+    QObject::connect(_ui.tableView->selectionModel(), &QItemSelectionModel::selectionChanged,
+                     this, &HistoryViewer::_itemSelectionChanged);
 
+    _updateCount();
     _itemSelectionChanged();
 }
 
 void HistoryViewer::_onPbCopyClipboardClicked()
 {
-    const auto selectedItems = _getUniqueItemPerSelectedRow();
-    QJsonArray jsonRequests;
-    for (const auto & item : selectedItems)
+    const auto requests = _getSelectedRequests();
+
+    QByteArray data;
+    QBuffer    buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    qint64 contentSize = 0;
+    RequestExporter exporter(&buffer);
+    for (const auto & request : requests)
     {
-        const auto request = _getRequestForItem(item);
-        jsonRequests.append(request->toJson());
+        exporter.write(*request);
+        contentSize += request->content.size() + request->responseContent.size();
     }
+    exporter.finish();
+
+    // The JSON export is also provided for the other applications as long as
+    // it stays reasonably small
+    auto mimeData = new QMimeData;
+    mimeData->setData(Constants::binaryExportMimeType, data);
+    if (contentSize <= Constants::maxClipboardJsonSize)
+        mimeData->setText(_requestsToJson(requests));
 
     _dataCameFromOwnCopy = true;
-    const auto json = QJsonObject{{Keys::requests, jsonRequests}};
-    auto clipboard  = QGuiApplication::clipboard();
-    clipboard->setText(QJsonDocument(json).toJson());
+    auto clipboard = QGuiApplication::clipboard();
+    clipboard->setMimeData(mimeData);
+}
+
+void HistoryViewer::_onPbExportClicked()
+{
+    static auto directoryPath = QDir::homePath();
+    const auto filter   = QString("HttpRequester requests (*.%1);;JSON (*.json)").arg(Constants::binaryExportSuffix);
+    const auto filename = QFileDialog::getSaveFileName(this, "Export requests to file", directoryPath, filter);
+    if (filename.isEmpty())
+        return ;
+    directoryPath = QFileInfo(filename).absoluteFilePath();
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        QMessageBox::critical(this, "Export failed", QString("Failed to open file '%1': %2")
+                              .arg(filename).arg(file.errorString()));
+        return ;
+    }
+
+    // The requests are written one by one, directly into the file
+    const auto requests = _getSelectedRequests();
+    if (QFileInfo(filename).suffix().compare("json", Qt::CaseInsensitive) == 0)
+        file.write(_requestsToJson(requests));
+    else
+    {
+        RequestExporter exporter(&file);
+        for (const auto & request : requests)
+            if (!exporter.write(*request))
+                break;
+        exporter.finish();
+    }
+
+    if (!file.commit())
+        QMessageBox::critical(this, "Export failed", QString("Failed to write file '%1': %2")
+                              .arg(filename).arg(file.errorString()));
+}
+
+void HistoryViewer::_onPbImportClicked()
+{
+    static auto directoryPath = QDir::homePath();
+    const auto filter   = QString("HttpRequester requests (*.%1 *.json);;All files (*)").arg(Constants::binaryExportSuffix);
+    const auto filename = QFileDialog::getOpenFileName(this, "Import requests from file", directoryPath, filter);
+    if (filename.isEmpty())
+        return ;
+    directoryPath = QFileInfo(filename).absoluteFilePath();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        QMessageBox::critical(this, "Import failed", QString("Failed to open file '%1': %2")
+                              .arg(filename).arg(file.errorString()));
+        return ;
+    }
+
+    // Files which are not in the binary format are read as a JSON export
+    if (!RequestImporter::canRead(&file))
+    {
+        const auto requests = _requestsFromJson(file.readAll());
+        if (requests.isEmpty())
+            QMessageBox::critical(this, "Import failed", QString("File '%1' does not contain any request")
+                                  .arg(filename));
+        else
+            _importRequests(requests);
+        return ;
+    }
+
+    // The requests are recorded by chunks as they are read, so their bodies are
+    // written and then evicted from memory within its budget. Their number is
+    // only known once the file is read: the history is then evicted and the
+    // rows refreshed once
+    QVector<RequestPtr> imported;
+    QVector<RequestPtr> chunk;
+    RequestImporter importer(&file);
+    while (!importer.atEnd())
+    {
+        const auto request = importer.read();
+        if (request != nullptr && !request->isNull())
+            chunk.push_back(request);
+
+        if (chunk.size() >= Constants::importChunkSize || (importer.atEnd() && !chunk.isEmpty()))
+        {
+            _store->recordsAdded(chunk);
+            imported += chunk;
+            chunk.clear();
+        }
+    }
+
+    _evict(0, false);
+    _displayAdded(imported);
+    _selectRequests(imported);
+}
+
+void HistoryViewer::_onPbStatisticsClicked()
+{
+    // The dialog is kept to follow the statistics while it is open
+    if (_statisticsDialog == nullptr)
+    {
+        _statisticsDialog = new EndpointStatsDialog(_store->endpoints(), this);
+        QObject::connect(_store, &HistoryStore::statisticsChanged,
+                         _statisticsDialog, &EndpointStatsDialog::refresh);
+    }
+
+    _statisticsDialog->show();
+    _statisticsDialog->raise();
+}
+
+void HistoryViewer::_onFilterChanged()
+{
+    bool ok = false;
+    const auto statusCode = _ui.leStatusFilter->text().trimmed().toInt(&ok);
+
+    _filter.host       = _ui.leHostFilter->text().trimmed().toLower();
+    _filter.method     = _ui.leMethodFilter->text().trimmed().toUpper().toUtf8();
+    _filter.statusCode = ok ? statusCode : -1;
+    _filter.text       = SearchIndex::normalize(_ui.leSearch->text());
+
+    _model->setFilter(_filter);
+    _refresh();
+}
+
+void HistoryViewer::_onRequestsLoaded(const QVector<RequestPtr> & requests)
+{
+    if (_loadedCount == 0)
+        qInfo("History: %d most recent requests displayed after %lld ms", requests.size(), _store->loadTime());
+    _loadedCount += requests.size();
+
+    // Inserted without resetting the rows, so the selection, the current row
+    // and the scroll position made while loading are kept
+    _model->requestsAdded(requests);
+    _updateCount();
+}
+
+void HistoryViewer::_onLoadFinished()
+{
+    qInfo("History: %d requests loaded in %lld ms", _loadedCount, _store->loadTime());
+
+    // The maximum size may have been lowered since the history was saved, the
+    // rows are then refreshed once with the whole history, keeping the
+    // selection made while loading
+    const auto selected = _getSelectedRequests();
+    const auto current  = _model->request(_ui.tableView->currentIndex().row());
+    _evict(0, false);
+    _refresh();
+    _selectRequests(selected);
+
+    const auto currentRow = current == nullptr ? -1 : _model->row(current);
+    if (currentRow != -1)
+    {
+        const auto index = _model->index(currentRow, 0);
+        _ui.tableView->selectionModel()->setCurrentIndex(index, QItemSelectionModel::NoUpdate);
+        _ui.tableView->scrollTo(index);
+    }
+    emit loaded();
+}
+
+void HistoryViewer::_onRequestsRecorded(const QVector<RequestPtr> & requests)
+{
+    // Sent or imported while the files were replayed
+    _model->requestsAdded(requests);
+    _updateCount();
+}
+
+void HistoryViewer::_onTextsIndexed()
+{
+    // The loaded requests were not searched yet
+    if (!_filter.text.isEmpty())
+        _refresh();
 }
 
 void HistoryViewer::_onWindowFocusChanged(const QWindow * window)
@@ -325,3 +593,27 @@ void HistoryViewer::_onClipboardChanged(QClipboard::Mode mode)
     _clipboardModeChanged  = mode;
     _onWindowFocusChanged(qApp->focusWindow());
 }
+
+void HistoryViewer::_onStoreStatisticsChanged()
+{
+    // Identical bodies are stored once and share the same memory mapping, then
+    // compressed when it is worth it
+    const auto & statistics       = _store->statistics();
+    const auto   dedupRatio       = statistics.uniqueSize == 0 ? 1.0 :
+                                    static_cast<double>(statistics.referencedSize) / statistics.uniqueSize;
+    const auto   compressionRatio = statistics.storedSize == 0 ? 1.0 :
+                                    static_cast<double>(statistics.uniqueSize) / statistics.storedSize;
+    // Bodies evicted from memory are read back from the body files
+    const auto & memory = _store->memoryUsage();
+    _ui.lStorage->setText(QString("Bodies: %1 stored\nDedup x%2, compression x%3, %4 saved\n"
+                                  "Memory: bodies %5 of %6, cache %7\nheaders %8, view %9")
+                          .arg(HistoryModel::formatSize(statistics.storedSize))
+                          .arg(dedupRatio, 0, 'f', 1)
+                          .arg(compressionRatio, 0, 'f', 1)
+                          .arg(HistoryModel::formatSize(statistics.referencedSize - statistics.storedSize))
+                          .arg(HistoryModel::formatSize(memory.residentBodies))
+                          .arg(HistoryModel::formatSize(_store->memoryBudget()))
+                          .arg(HistoryModel::formatSize(memory.cachedBodies))
+                          .arg(HistoryModel::formatSize(memory.headers))
+                          .arg(HistoryModel::formatSize(memory.index + _model->memoryUsage())));
+}
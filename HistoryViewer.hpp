@@ -17,11 +17,17 @@
 // Project includes ------------------------------------------------------------
 #include "ui_HistoryViewer.h"
 #include "Request.hpp"
+#include "HistoryIndex.hpp"
+
+// Project forward declarations ------------------------------------------------
+class HistoryStore;
+class HistoryModel;
+class EndpointStatsDialog;
 
 // Qt forward declarations -----------------------------------------------------
 QT_BEGIN_NAMESPACE
-class QTableWidgetItem;
 class QKeyEvent;
+class QIODevice;
 QT_END_NAMESPACE
 
 class HistoryViewer : public QWidget
@@ -33,31 +39,39 @@ public:
 
     bool hasRequest(RequestPtr request) const;
     void updateRequest(RequestPtr request);
+    void updateRequestDisplayFormat(RequestPtr request);
     void addRequest(RequestPtr request);
-    const QVector<RequestPtr> & request() const { return _requests; }
+    void addRequests(const QVector<RequestPtr> & requests);
+    QVector<RequestPtr> recentRequests(int count) const;
+    void setCompressionEnabled(bool value);
+    void setMemoryBudget(qint64 size);
+    void setMaxHistorySize(int value) { _maxHistorySize = value; }
 
 public slots:
-    void load(QDataStream & in);
-    void save(QDataStream & out) const;
+    void openStore(const QString & basePath);
+    void closeStore();
 
 protected:
     void keyPressEvent(QKeyEvent * event) override;
 
 private:
-    void _addRequestToTable(const RequestPtr request);
-    void _fillTableRow(int row, const RequestPtr request);
-
-    int _getRequestIdxForItem(const QTableWidgetItem * item) const;
-    Request * _getRequestForItem(const QTableWidgetItem * item) const;
-    int _getRowForRequest(const Request * request) const;
+    void _refresh();
+    void _updateCount();
+    // The rows are not updated when the model is refreshed afterwards
+    void _evict(int count, bool updateRows = true);
 
-    QVector<QTableWidgetItem *> _getUniqueItemPerSelectedRow() const;
+    QVector<int> _getSelectedRows() const;
+    QVector<RequestPtr> _getSelectedRequests() const;
 
     void _tryLoadRequestFromClipboard(QClipboard::Mode mode);
+    void _displayAdded(const QVector<RequestPtr> & requests);
+    void _importRequests(const QVector<RequestPtr> & requests);
+    void _selectRequests(const QVector<RequestPtr> & requests);
 
 private:
-    static QTableWidgetItem * _createTableItem(const QString & text = {}, bool dateTime = false);
-    static QString _formatSize(qint32 size);
+    static QByteArray _requestsToJson(const QVector<RequestPtr> & requests);
+    static QVector<RequestPtr> _requestsFromJson(const QByteArray & data);
+    static QVector<RequestPtr> _requestsFromBinary(QIODevice * device);
 
 private slots:
     void _itemSelectionChanged();
@@ -65,17 +79,35 @@ private slots:
     void _onPbClearClicked();
     void _onPbDeleteClicked();
     void _onPbCopyClipboardClicked();
+    void _onPbExportClicked();
+    void _onPbImportClicked();
+    void _onPbStatisticsClicked();
+
+    void _onFilterChanged();
 
     void _onClipboardChanged(QClipboard::Mode mode);
     void _onWindowFocusChanged(const QWindow * window);
 
+    void _onStoreStatisticsChanged();
+    void _onRequestsLoaded(const QVector<RequestPtr> & requests);
+    void _onRequestsRecorded(const QVector<RequestPtr> & requests);
+    void _onLoadFinished();
+    void _onTextsIndexed();
+
 signals:
     void currentChanged(RequestPtr request);
+    void loaded();
 
 private:
-    Ui::HistoryViewer _ui;
+    Ui::HistoryViewer     _ui;
+    HistoryStore        * _store;
+    HistoryModel        * _model;
+    EndpointStatsDialog * _statisticsDialog = nullptr;
+
+    HistoryIndex::Filter _filter;
+    int                  _maxHistorySize;
+    int                  _loadedCount = 0;
 
-    QVector<RequestPtr> _requests;
     bool                _hasNewDataInClipboard = false;
     bool                _dataCameFromOwnCopy = false;
     QClipboard::Mode    _clipboardModeChanged;
@@ -1,4 +1,4 @@
-QT += core gui widgets network
+QT += core gui widgets network concurrent
 
 TARGET = HttpRequester
 CONFIG += console
@@ -8,13 +8,44 @@ TEMPLATE = app
 
 CONFIG += c++11
 
+# gzip and deflate are decoded with zlib, brotli and zstd only when available
+LIBS += -lz
+CONFIG += link_pkgconfig
+packagesExist(libbrotlidec) {
+    PKGCONFIG += libbrotlidec
+    DEFINES += HAVE_BROTLI
+}
+packagesExist(libzstd) {
+    PKGCONFIG += libzstd
+    DEFINES += HAVE_ZSTD
+}
+
 SOURCES += main.cpp \
     MainWindow.cpp \
     RequestBuilder.cpp \
     ResponseViewer.cpp \
     HistoryViewer.cpp \
     Request.cpp \
-    QJsonModel.cpp
+    QJsonModel.cpp \
+    HistoryStore.cpp \
+    Body.cpp \
+    BlobStore.cpp \
+    RequestExport.cpp \
+    HistoryIndex.cpp \
+    SearchIndex.cpp \
+    HistoryModel.cpp \
+    LatencyHistogram.cpp \
+    EndpointStatistics.cpp \
+    EndpointStatsDialog.cpp \
+    HistogramView.cpp \
+    BodyBuffer.cpp \
+    LargeTextView.cpp \
+    FormatCache.cpp \
+    RequestTimer.cpp \
+    WaterfallView.cpp \
+    TransferRate.cpp \
+    ContentDecoder.cpp \
+    HexView.cpp
 
 HEADERS += \
     MainWindow.hpp \
@@ -23,11 +54,31 @@ HEADERS += \
     HistoryViewer.hpp \
     Request.hpp \
     QJsonModel.hpp \
-    DateTimeItem.hpp \
-    Constants.hpp
+    Constants.hpp \
+    HistoryStore.hpp \
+    Body.hpp \
+    BlobStore.hpp \
+    RequestExport.hpp \
+    HistoryIndex.hpp \
+    SearchIndex.hpp \
+    StringPool.hpp \
+    HistoryModel.hpp \
+    LatencyHistogram.hpp \
+    EndpointStatistics.hpp \
+    EndpointStatsDialog.hpp \
+    HistogramView.hpp \
+    BodyBuffer.hpp \
+    LargeTextView.hpp \
+    FormatCache.hpp \
+    RequestTimer.hpp \
+    WaterfallView.hpp \
+    TransferRate.hpp \
+    ContentDecoder.hpp \
+    HexView.hpp
 
 FORMS += \
     RequestBuilder.ui \
     ResponseViewer.ui \
     HistoryViewer.ui \
+    EndpointStatsDialog.ui \
     MainWindow.ui
@@ -0,0 +1,228 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "LargeTextView.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QApplication>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QtConcurrent>
+
+// C++ standard library includes -----------------------------------------------
+#include <cstring>
+
+namespace
+{
+// Indexed before the view is displayed, the rest is indexed by the worker
+constexpr const qint64 synchronousIndexSize = 256 * 1024;
+constexpr const auto   textMargin           = 4;
+} // !namespace
+
+LargeTextView::LargeTextView(QWidget * parent) :
+    QAbstractScrollArea(parent),
+    _complete(true),
+    _maxLineWidth(0)
+{
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+
+    QObject::connect(&_indexer, &QFutureWatcher<Indexed>::finished,
+                     this, &LargeTextView::_onIndexed);
+}
+
+LargeTextView::~LargeTextView()
+{
+    _cancelIndexing();
+}
+
+void LargeTextView::setData(const Body & body)
+{
+    // A compressed body is decompressed by the worker, so the GUI thread does
+    // not wait for it and the worker does not use the cache of the store
+    _cancelIndexing();
+    const auto compressed = body.isCompressed();
+    _reader       = BodyReader(compressed ? Body() : body);
+    _lines        = _index(_reader.body(), synchronousIndexSize, nullptr);
+    _complete     = !compressed && _reader.size() <= synchronousIndexSize;
+    _maxLineWidth = 0;
+
+    if (!_complete)
+    {
+        // The worker holds its own reference on the body and stops as soon as
+        // other data is set
+        const auto canceled = std::make_shared<std::atomic<bool>>(false);
+        _canceled = canceled;
+        _indexer.setFuture(QtConcurrent::run([body, canceled]
+        {
+            const auto text = body.isCompressed() ? Body(body.uncachedData()) : body;
+            return qMakePair(text, _index(text, text.size(), canceled.get()));
+        }));
+    }
+
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    _updateScrollBars();
+    viewport()->update();
+}
+
+void LargeTextView::clear()
+{
+    setData({});
+}
+
+QString LargeTextView::visibleText() const
+{
+    const auto lineHeight = fontMetrics().height();
+    const auto first      = verticalScrollBar()->value();
+    const auto last       = qMin(_lines.size(), first + viewport()->height() / lineHeight + 1);
+
+    QStringList lines;
+    for (auto i = first; i < last; ++i)
+        lines.append(_line(i));
+    return lines.join('\n');
+}
+
+void LargeTextView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), palette().base());
+    painter.setPen(palette().text().color());
+
+    const auto metrics    = fontMetrics();
+    const auto lineHeight = metrics.height();
+    const auto first      = verticalScrollBar()->value();
+    const auto x          = textMargin - horizontalScrollBar()->value();
+    auto       y          = metrics.ascent();
+
+    // Only the visible lines are decoded
+    for (auto i = first; i < _lines.size() && y - metrics.ascent() < viewport()->height(); ++i)
+    {
+        const auto line = _line(i);
+        painter.drawText(x, y, line);
+        _maxLineWidth = qMax(_maxLineWidth, metrics.width(line));
+        y += lineHeight;
+    }
+
+    if (!_complete)
+        painter.drawText(viewport()->rect().adjusted(0, 0, -textMargin, -textMargin),
+                         Qt::AlignRight | Qt::AlignBottom, "Indexing lines...");
+
+    // The width of the text is only known from the lines already displayed
+    if (horizontalScrollBar()->maximum() < _maxLineWidth - viewport()->width() + 2 * textMargin)
+        _updateScrollBars();
+}
+
+void LargeTextView::resizeEvent(QResizeEvent * event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    _updateScrollBars();
+}
+
+void LargeTextView::keyPressEvent(QKeyEvent * event)
+{
+    if (event->matches(QKeySequence::Copy))
+        QGuiApplication::clipboard()->setText(visibleText());
+    else if (event->matches(QKeySequence::MoveToStartOfDocument))
+        verticalScrollBar()->setValue(0);
+    else if (event->matches(QKeySequence::MoveToEndOfDocument))
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    else if (event->matches(QKeySequence::MoveToNextPage))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepAdd);
+    else if (event->matches(QKeySequence::MoveToPreviousPage))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderPageStepSub);
+    else if (event->matches(QKeySequence::MoveToNextLine))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    else if (event->matches(QKeySequence::MoveToPreviousLine))
+        verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    else
+        QAbstractScrollArea::keyPressEvent(event);
+}
+
+void LargeTextView::_onIndexed()
+{
+    if (_indexer.future().isCanceled() || _canceled == nullptr || *_canceled)
+        return ;
+
+    const auto indexed = _indexer.result();
+    _reader   = BodyReader(indexed.first);
+    _lines    = indexed.second;
+    _complete = true;
+    _canceled.reset();
+    _updateScrollBars();
+    viewport()->update();
+}
+
+void LargeTextView::_cancelIndexing()
+{
+    if (_canceled != nullptr)
+        *_canceled = true;
+    _canceled.reset();
+}
+
+void LargeTextView::_updateScrollBars()
+{
+    const auto lineHeight   = fontMetrics().height();
+    const auto visibleLines = qMax(1, viewport()->height() / lineHeight);
+    verticalScrollBar()->setRange(0, qMax(0, _lines.size() - visibleLines));
+    verticalScrollBar()->setPageStep(visibleLines);
+    verticalScrollBar()->setSingleStep(1);
+
+    horizontalScrollBar()->setRange(0, qMax(0, _maxLineWidth - viewport()->width() + 2 * textMargin));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(fontMetrics().averageCharWidth() * 4);
+}
+
+QString LargeTextView::_line(int index) const
+{
+    const auto start = _lines.at(index);
+    auto       end   = index + 1 < _lines.size() ? _lines.at(index + 1) : _reader.size();
+    if (!_complete && index + 1 == _lines.size())
+        end = qMin(end, synchronousIndexSize);
+
+    // The line feed ending the line is not displayed
+    const auto bytes  = _reader.read(start, static_cast<int>(end - start));
+    auto       length = bytes.size();
+    while (length > 0 && (bytes.at(length - 1) == '\n' || bytes.at(length - 1) == '\r'))
+        --length;
+    return QString::fromUtf8(bytes.constData(), length);
+}
+
+LargeTextView::LineIndex LargeTextView::_index(const Body & body, qint64 limit, const std::atomic<bool> * canceled)
+{
+    LineIndex lines;
+    if (body.isEmpty())
+        return lines;
+
+    // The view reads the displayed lines meanwhile, with its own reader
+    BodyReader reader(body);
+    const auto end  = qMin(limit, body.size());
+    qint64     line = 0;
+    lines.push_back(0);
+    while (line < end)
+    {
+        if (canceled != nullptr && (lines.size() % 4096) == 0 && *canceled)
+            return {};
+
+        // A line longer than maxLineLength is continued on the next one
+        const auto chunk = reader.read(line, static_cast<int>(qMin<qint64>(maxLineLength, end - line)));
+        if (chunk.isEmpty())
+            break;
+
+        const auto feed = static_cast<const char *>(std::memchr(chunk.constData(), '\n', static_cast<std::size_t>(chunk.size())));
+        line += feed != nullptr ? feed - chunk.constData() + 1 : chunk.size();
+        if (line < end)
+            lines.push_back(line);
+    }
+
+    return lines;
+}
@@ -0,0 +1,74 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QAbstractScrollArea>
+#include <QFutureWatcher>
+#include <QVector>
+
+// Project includes ------------------------------------------------------------
+#include "Body.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <atomic>
+#include <memory>
+
+// Read-only view of a text too large for a QPlainTextEdit.
+//
+// The text is read by pages, which are windows of its memory mapping when it is
+// stored, and only the lines in the visible window are decoded and drawn. The offsets
+// of the lines are indexed by a worker; lines longer than maxLineLength are
+// split in chunks of that length so a single giant line scrolls like any
+// other text. Until the index is complete the beginning of the text, indexed
+// right away, is displayed. A compressed text is only displayed once the
+// worker has decompressed it.
+class LargeTextView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr const int maxLineLength = 4096;
+
+    using LineIndex = QVector<qint64>;
+    using Indexed   = QPair<Body, LineIndex>;   // Decompressed by the worker
+
+public:
+    explicit LargeTextView(QWidget * parent = nullptr);
+    ~LargeTextView() override;
+
+    void setData(const Body & body);
+    void clear();
+
+    // Text of the displayed lines, for a copy
+    QString visibleText() const;
+
+protected:
+    void paintEvent(QPaintEvent * event) override;
+    void resizeEvent(QResizeEvent * event) override;
+    void keyPressEvent(QKeyEvent * event) override;
+
+private:
+    void _onIndexed();
+    void _cancelIndexing();
+    void _updateScrollBars();
+    QString _line(int index) const;
+
+private:
+    static LineIndex _index(const Body & body, qint64 limit, const std::atomic<bool> * canceled);
+
+private:
+    mutable BodyReader                 _reader;
+    LineIndex                          _lines;   // Offset of each line start
+    bool                               _complete;
+    QFutureWatcher<Indexed>            _indexer;
+    std::shared_ptr<std::atomic<bool>> _canceled;
+    int                                _maxLineWidth;
+};
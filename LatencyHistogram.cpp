@@ -0,0 +1,122 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "LatencyHistogram.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QtAlgorithms>
+
+// C++ standard library includes -----------------------------------------------
+#include <cmath>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+
+void LatencyHistogram::add(quint32 value)
+{
+    ++_counts[static_cast<std::size_t>(bucketIndex(value))];
+    ++_count;
+    _max = qMax(_max, value);
+}
+
+void LatencyHistogram::remove(quint32 value)
+{
+    auto & counter = _counts[static_cast<std::size_t>(bucketIndex(value))];
+    if (counter == 0)
+        return ;
+
+    --counter;
+    --_count;
+
+    // The exact maximum is lost, it is bounded by the last bucket
+    if (value >= _max)
+        _max = _count == 0 ? 0 : qMin(_max, upperBound(lastBucket()));
+}
+
+void LatencyHistogram::merge(const LatencyHistogram & other)
+{
+    for (std::size_t i = 0; i < _counts.size(); ++i)
+        _counts[i] += other._counts[i];
+    _count += other._count;
+    _max    = qMax(_max, other._max);
+}
+
+void LatencyHistogram::clear()
+{
+    _counts.fill(0);
+    _count = 0;
+    _max   = 0;
+}
+
+quint32 LatencyHistogram::percentile(double fraction) const
+{
+    if (_count == 0)
+        return 0;
+
+    // The value reported for a bucket is its upper bound, the percentiles are
+    // therefore never underestimated
+    const auto rank = qMax<qint64>(1, static_cast<qint64>(std::ceil(fraction * _count)));
+    qint64 seen = 0;
+    for (auto i = 0; i < bucketCount; ++i)
+    {
+        seen += _counts[static_cast<std::size_t>(i)];
+        if (seen >= rank)
+            return qMin(_max, upperBound(i));
+    }
+
+    return _max;
+}
+
+int LatencyHistogram::firstBucket() const
+{
+    for (auto i = 0; i < bucketCount; ++i)
+        if (_counts[static_cast<std::size_t>(i)] != 0)
+            return i;
+    return -1;
+}
+
+int LatencyHistogram::lastBucket() const
+{
+    for (auto i = bucketCount - 1; i >= 0; --i)
+        if (_counts[static_cast<std::size_t>(i)] != 0)
+            return i;
+    return -1;
+}
+
+int LatencyHistogram::bucketIndex(quint32 value)
+{
+    // The values below subBucketCount have a bucket of their own, then each
+    // power of two has subBucketCount buckets
+    if (value < static_cast<quint32>(subBucketCount))
+        return static_cast<int>(value);
+
+    const auto highestBit = 31 - static_cast<int>(qCountLeadingZeroBits(value));
+    const auto shift      = highestBit - subBucketBits;
+    const auto subBucket  = static_cast<int>((value >> shift) & (subBucketCount - 1));
+    return (shift + 1) * subBucketCount + subBucket;
+}
+
+quint32 LatencyHistogram::lowerBound(int index)
+{
+    const auto group     = index / subBucketCount;
+    const auto subBucket = static_cast<quint32>(index % subBucketCount);
+    if (group == 0)
+        return subBucket;
+    return (static_cast<quint32>(subBucketCount) + subBucket) << (group - 1);
+}
+
+quint32 LatencyHistogram::upperBound(int index)
+{
+    if (index + 1 >= bucketCount)
+        return std::numeric_limits<quint32>::max();
+    return lowerBound(index + 1) - 1;
+}
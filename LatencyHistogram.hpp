@@ -0,0 +1,57 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QtGlobal>
+
+// C++ standard library includes -----------------------------------------------
+#include <array>
+
+// Histogram of latencies, in milliseconds, with a fixed memory footprint.
+//
+// The values are counted in log-linear buckets: each power of two is divided
+// in 16 buckets of the same width, so a percentile is known within 1/16 of its
+// value whatever the range of the latencies. Histograms are merged by adding
+// their counts and a value can be removed as well, so a histogram follows the
+// requests as they are updated and removed.
+class LatencyHistogram
+{
+public:
+    static constexpr const int subBucketBits  = 4;
+    static constexpr const int subBucketCount = 1 << subBucketBits;
+    static constexpr const int bucketCount    = (32 - subBucketBits + 1) * subBucketCount;
+
+public:
+    LatencyHistogram();
+
+    void add(quint32 value);
+    void remove(quint32 value);
+    void merge(const LatencyHistogram & other);
+    void clear();
+
+    int count() const     { return _count; }
+    quint32 max() const   { return _max; }
+    quint32 percentile(double fraction) const;
+
+    int bucket(int index) const { return static_cast<int>(_counts[static_cast<std::size_t>(index)]); }
+    int firstBucket() const;
+    int lastBucket() const;
+
+public:
+    static int bucketIndex(quint32 value);
+    static quint32 lowerBound(int index);
+    static quint32 upperBound(int index);
+
+private:
+    std::array<quint32, bucketCount> _counts;
+    int                              _count;
+    quint32                          _max;
+};
@@ -9,15 +9,53 @@
 
 #include "MainWindow.hpp"
 
+// Project includes ------------------------------------------------------------
+#include "Constants.hpp"
+#include "HistoryModel.hpp"
+#include "TransferRate.hpp"
+
 // Qt includes -----------------------------------------------------------------
 #include <QApplication>
 #include <QNetworkReply>
 #include <QStandardPaths>
-#include <QFile>
 #include <QDir>
 #include <QSettings>
 #include <QShortcut>
 #include <QProgressDialog>
+#include <QElapsedTimer>
+
+// C++ standard library includes -----------------------------------------------
+#include <memory>
+
+namespace
+{
+constexpr const auto progressRefreshInterval = 100;
+// The dialog takes an int, the transfers are scaled to it whatever their size
+constexpr const auto progressRange           = 1000;
+
+QString formatRemaining(qint64 milliseconds)
+{
+    const auto seconds = (milliseconds + 999) / 1000;
+    if (seconds < 60)
+        return QString("%1 s").arg(seconds);
+    return QString("%1 min %2 s").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+QString progressText(const QString & direction, const TransferRate & rate, qint64 total)
+{
+    auto text = QString("%1: %2").arg(direction).arg(HistoryModel::formatSize(rate.bytes()));
+    if (total > 0)
+        text += QString(" of %1").arg(HistoryModel::formatSize(total));
+
+    text += QString("\n%1/s, average %2/s").arg(HistoryModel::formatSize(rate.current()))
+                                           .arg(HistoryModel::formatSize(rate.average()));
+
+    const auto remaining = rate.remaining(total);
+    if (remaining >= 0)
+        text += QString(", %1 left").arg(formatRemaining(remaining));
+    return text;
+}
+} // !namespace
 
 MainWindow::MainWindow()
 {
@@ -39,10 +77,36 @@ MainWindow::MainWindow()
         _dialog->setLabelText("Waiting response...");
         _dialog->setMinimumDuration(0);
         _dialog->open();
-        QObject::connect(reply, &QNetworkReply::downloadProgress, [this](qint64 bytesReceived, qint64 bytesTotal)
+
+        // The label is refreshed at a bounded frequency, the progress signals
+        // are emitted for every chunk
+        const auto upload   = std::make_shared<TransferRate>();
+        const auto download = std::make_shared<TransferRate>();
+        const auto refresh  = std::make_shared<QElapsedTimer>();
+        const auto progress = [this, refresh](const QString & direction, const TransferRate & rate,
+                                              qint64 bytes, qint64 total)
         {
-            _dialog->setMaximum(bytesTotal);
-            _dialog->setValue(bytesReceived);
+            // An unknown total shows a busy indicator
+            _dialog->setMaximum(total > 0 ? progressRange : 0);
+            _dialog->setValue(total > 0 ? static_cast<int>(qBound<qint64>(0, bytes * progressRange / total, progressRange)) : 0);
+            if (refresh->isValid() && refresh->elapsed() < progressRefreshInterval && bytes != total)
+                return ;
+
+            refresh->start();
+            _dialog->setLabelText(progressText(direction, rate, total));
+        };
+
+        QObject::connect(reply, &QNetworkReply::uploadProgress, [upload, progress](qint64 bytesSent, qint64 bytesTotal)
+        {
+            if (bytesTotal <= 0)
+                return ; // No body to send
+            upload->update(bytesSent);
+            progress("Uploading", *upload, bytesSent, bytesTotal);
+        });
+        QObject::connect(reply, &QNetworkReply::downloadProgress, [download, progress](qint64 bytesReceived, qint64 bytesTotal)
+        {
+            download->update(bytesReceived);
+            progress("Downloading", *download, bytesReceived, bytesTotal);
         });
 
         QObject::connect(_dialog, &QProgressDialog::canceled, reply, &QNetworkReply::abort);
@@ -61,9 +125,18 @@ MainWindow::MainWindow()
         _ui.requestBuilder->displayRequest(request);
     });
 
+    QObject::connect(_ui.responseViewer, &ResponseViewer::displayFormatChanged,
+                     _ui.historyViewer, &HistoryViewer::updateRequestDisplayFormat);
+
+    // The completion is only set once the whole history is loaded
+    QObject::connect(_ui.historyViewer, &HistoryViewer::loaded, [this]
+    {
+        _ui.requestBuilder->setRequestForCompletion(_ui.historyViewer->recentRequests(Constants::completionSize));
+    });
+
     QObject::connect(qApp, &QCoreApplication::aboutToQuit, [this]
     {
-        _saveOrLoadHistoryData(true);
+        _openOrCloseHistoryData(false);
         _saveOrLoadWindow(true);
     });
 
@@ -73,45 +146,51 @@ MainWindow::MainWindow()
 
 void MainWindow::restoreState()
 {
-    _saveOrLoadHistoryData(false);
+    // The window is shown while the history is loaded
+    _openOrCloseHistoryData(true);
     _saveOrLoadWindow(false);
-
-    _ui.requestBuilder->setRequestForCompletion(_ui.historyViewer->request());
 }
 
-void MainWindow::_saveOrLoadHistoryData(bool save)
+void MainWindow::_openOrCloseHistoryData(bool open)
 {
-    static const auto filename = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/request_ui.history";
-    if (save)
+    if (!open)
     {
-        const auto absolutePath = QFileInfo(filename).absolutePath();
-        if (!QDir::root().mkpath(absolutePath))
-        {
-            qWarning("Failed to create directory at '%s'", qPrintable(absolutePath));
-            return ;
-        }
+        _ui.historyViewer->closeStore();
+        return ;
     }
 
-    QFile file(filename);
-    if (save)
+    static const auto basePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/request_ui";
+    const auto absolutePath = QFileInfo(basePath).absolutePath();
+    if (!QDir::root().mkpath(absolutePath))
     {
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
-        {
-            qWarning("Unable to open/create file '%s': %s", qPrintable(filename), qPrintable(file.errorString()));
-            return ;
-        }
-    }
-    else if (!file.open(QIODevice::ReadOnly))
+        qWarning("Failed to create directory at '%s'", qPrintable(absolutePath));
         return ;
+    }
 
-    QDataStream stream(&file);
-    stream.setByteOrder(QDataStream::LittleEndian);
-    stream.setVersion(QDataStream::Qt_5_6);
-
-    if (save)
-        _ui.historyViewer->save(stream);
-    else
-        _ui.historyViewer->load(stream);
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings settings;
+    settings.beginGroup("History");
+    _ui.historyViewer->setCompressionEnabled(settings.value("compressBodies", true).toBool());
+    _ui.historyViewer->setMaxHistorySize(settings.value("maxSize", Constants::maxHistorySize).toInt());
+    // In megabytes
+    _ui.historyViewer->setMemoryBudget(settings.value("memoryBudget", Constants::memoryBudget / (1024 * 1024)).toLongLong() * 1024 * 1024);
+    settings.endGroup();
+
+    // Responses larger than the threshold, in megabytes, are received in a
+    // temporary file
+    settings.beginGroup("Response");
+    _ui.responseViewer->setSpillThreshold(settings.value("spillThreshold", Constants::spillThreshold / (1024 * 1024)).toLongLong() * 1024 * 1024);
+    // Formatted bodies kept for the display, in megabytes as well
+    _ui.responseViewer->setFormatCacheSize(settings.value("formatCacheSize", Constants::formatCacheSize / (1024 * 1024)).toLongLong() * 1024 * 1024);
+    settings.endGroup();
+
+    // Off by default, the network access manager then negotiates and decodes
+    // gzip and deflate on its own
+    settings.beginGroup("Request");
+    _ui.requestBuilder->setContentNegotiationEnabled(settings.value("negotiateEncoding", false).toBool());
+    settings.endGroup();
+
+    _ui.historyViewer->openStore(basePath);
 }
 
 void MainWindow::_saveOrLoadWindow(bool save)
@@ -28,7 +28,7 @@ public:
     void restoreState();
 
 private:
-    void _saveOrLoadHistoryData(bool save);
+    void _openOrCloseHistoryData(bool open);
     void _saveOrLoadWindow(bool save);
 
 private:
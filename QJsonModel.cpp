@@ -110,9 +110,9 @@ QString QJsonTreeItem::jsonTypeToString(QJsonValue::Type type)
 //=========================================================================
 
 QJsonModel::QJsonModel(QObject * parent) :
-    QAbstractItemModel(parent)
+    QAbstractItemModel(parent),
+    _rootItem(std::make_shared<QJsonTreeItem>())
 {
-    _rootItem = new QJsonTreeItem;
 }
 
 bool QJsonModel::load(const QString & fileName)
@@ -135,20 +135,26 @@ bool QJsonModel::load(QIODevice * device)
 
 bool QJsonModel::loadJson(const QByteArray & json)
 {
-    _document = QJsonDocument::fromJson(json);
+    const auto document = QJsonDocument::fromJson(json);
+    if (document.isNull())
+        return false;
 
-    if (!_document.isNull())
-    {
-        beginResetModel();
-        if (_document.isArray())
-            _rootItem = QJsonTreeItem::load(QJsonValue(_document.array()));
-        else
-            _rootItem = QJsonTreeItem::load(QJsonValue(_document.object()));
-        endResetModel();
-        return true;
-    }
+    setRoot(build(document));
+    return true;
+}
 
-    return false;
+void QJsonModel::setRoot(const QJsonTreeItemPtr & root)
+{
+    beginResetModel();
+    _rootItem = root == nullptr ? std::make_shared<QJsonTreeItem>() : root;
+    endResetModel();
+}
+
+QJsonTreeItemPtr QJsonModel::build(const QJsonDocument & document)
+{
+    if (document.isArray())
+        return QJsonTreeItemPtr(QJsonTreeItem::load(QJsonValue(document.array())));
+    return QJsonTreeItemPtr(QJsonTreeItem::load(QJsonValue(document.object())));
 }
 
 QVariant QJsonModel::data(const QModelIndex & index, int role) const
@@ -184,7 +190,7 @@ QModelIndex QJsonModel::index(int row, int column, const QModelIndex & parent) c
     QJsonTreeItem * parentItem;
 
     if (!parent.isValid())
-        parentItem = _rootItem;
+        parentItem = _rootItem.get();
     else
         parentItem = static_cast<QJsonTreeItem *>(parent.internalPointer());
 
@@ -203,7 +209,7 @@ QModelIndex QJsonModel::parent(const QModelIndex & index) const
     auto childItem = static_cast<QJsonTreeItem *>(index.internalPointer());
     auto parentItem = childItem->parent();
 
-    if (parentItem == _rootItem)
+    if (parentItem == _rootItem.get())
         return QModelIndex();
 
     return createIndex(parentItem->row(), 0, parentItem);
@@ -234,7 +240,7 @@ int QJsonModel::rowCount(const QModelIndex & parent) const
         return 0;
 
     if (!parent.isValid())
-        parentItem = _rootItem;
+        parentItem = _rootItem.get();
     else
         parentItem = static_cast<QJsonTreeItem *>(parent.internalPointer());
 
@@ -17,6 +17,9 @@
 #include <QJsonObject>
 #include <QIcon>
 
+// C++ standard library includes -----------------------------------------------
+#include <memory>
+
 // Qt forward declarations -----------------------------------------------------
 QT_BEGIN_NAMESPACE
 class QJsonModel;
@@ -56,6 +59,8 @@ private:
     QJsonTreeItem *        _parent;
 };
 
+using QJsonTreeItemPtr = std::shared_ptr<QJsonTreeItem>;
+
 //---------------------------------------------------
 
 class QJsonModel : public QAbstractItemModel
@@ -67,6 +72,11 @@ public:
     bool load(QIODevice * device);
     bool loadJson(const QByteArray & json);
 
+    // The tree may be shared with a cache, it is only deleted once released
+    void setRoot(const QJsonTreeItemPtr & root);
+
+    static QJsonTreeItemPtr build(const QJsonDocument & document);
+
     QVariant data(const QModelIndex & index, int role) const override;
     QVariant headerData(int, Qt::Orientation, int) const override;
     QModelIndex index(int row, int column,const QModelIndex & parent = {}) const override;
@@ -80,7 +90,5 @@ public:
     Qt::ItemFlags flags(const QModelIndex & index) const override;
 
 private:
-    QJsonTreeItem * _rootItem;
-    QJsonDocument   _document;
-
+    QJsonTreeItemPtr _rootItem;
 };
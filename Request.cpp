@@ -47,6 +47,35 @@ void headerFromJson(const QJsonObject & json, QNetworkRequest & request)
                              QByteArray::fromBase64(itr.value().toString().toUtf8()));
 }
 
+QJsonObject timingsToJson(const RequestTimings & timings)
+{
+    return QJsonObject{
+        { "queued",     static_cast<double>(timings.queued)    },
+        { "resolved",   static_cast<double>(timings.resolved)  },
+        { "encrypted",  static_cast<double>(timings.encrypted) },
+        { "sent",       static_cast<double>(timings.sent)      },
+        { "first_byte", static_cast<double>(timings.firstByte) },
+        { "last_byte",  static_cast<double>(timings.lastByte)  },
+        { "decoding",   static_cast<double>(timings.decoding)  }
+    };
+}
+
+RequestTimings timingsFromJson(const QJsonObject & json)
+{
+    const auto value = [&json](const char * key)
+    { return static_cast<qint64>(json.value(key).toDouble(-1)); };
+
+    RequestTimings timings;
+    timings.queued    = value("queued");
+    timings.resolved  = value("resolved");
+    timings.encrypted = value("encrypted");
+    timings.sent      = value("sent");
+    timings.firstByte = value("first_byte");
+    timings.lastByte  = value("last_byte");
+    timings.decoding  = value("decoding");
+    return timings;
+}
+
 void from18Request(const QJsonObject & json, Request & request)
 {
     const auto jsonRequest  = json.value(Keys::request).toObject();
@@ -66,30 +95,50 @@ void from18Request(const QJsonObject & json, Request & request)
     request.date          = QDateTime::fromString(json.value(Keys::requestDate).toString(), Constants::exportDateFormat);
     request.elapsedTime   = static_cast<quint32>(json.value(Keys::requestElaspedTime).toInt());
     request.displayFormat = json.value(Keys::responseDisplayFormat).toInt();
+
+    // Exported by later 1.8 builds only
+    request.timings    = timingsFromJson(json.value(Keys::requestTimings).toObject());
+    request.throughput = static_cast<qint64>(json.value(Keys::requestThroughput).toDouble());
+    request.wireSize   = static_cast<qint64>(jsonResponse.value(Keys::responseWireSize)
+                                             .toDouble(request.responseContent.size()));
+
+    const auto jsonDownload = jsonResponse.value(Keys::responseDownload).toObject();
+    request.downloadPath = jsonDownload.value(Keys::downloadPath).toString();
+    request.downloadSize = static_cast<qint64>(jsonDownload.value(Keys::downloadSize).toDouble());
+    request.downloadHash = jsonDownload.value(Keys::downloadHash).toString().toLatin1();
 }
 } // !namespace
 
 QJsonObject Request::toJson() const
 {
     const QJsonObject jsonRequest{
-        { Keys::requestMethod,            method.constData()             },
-        { Keys::requestUrl,               url().toString()               },
-        { Keys::requestContentIsFilename, contentIsFilename              },
-        { Keys::requestContent,           content.toBase64().constData() },
-        { Keys::requestHeaders,           headerToJson(*this)            }
+        { Keys::requestMethod,            method.constData()                    },
+        { Keys::requestUrl,               url().toString()                      },
+        { Keys::requestContentIsFilename, contentIsFilename                     },
+        { Keys::requestContent,           content.data().toBase64().constData() },
+        { Keys::requestHeaders,           headerToJson(*this)                   }
     };
-    const QJsonObject jsonResponse{
-        { Keys::responseStatus,  static_cast<qint32>(statusCode)        },
-        { Keys::responseReason,  reasonPhrase                           },
-        { Keys::responseContent, responseContent.toBase64().constData() },
-        { Keys::responseHeaders, headerToJson(responseHeaders)          }
+    QJsonObject jsonResponse{
+        { Keys::responseStatus,   static_cast<qint32>(statusCode)               },
+        { Keys::responseReason,   reasonPhrase                                  },
+        { Keys::responseContent,  responseContent.data().toBase64().constData() },
+        { Keys::responseHeaders,  headerToJson(responseHeaders)                 },
+        { Keys::responseWireSize, static_cast<double>(wireSize)                 }
     };
+    if (isDownload())
+        jsonResponse.insert(Keys::responseDownload, QJsonObject{
+            { Keys::downloadPath, downloadPath                      },
+            { Keys::downloadSize, static_cast<double>(downloadSize) },
+            { Keys::downloadHash, QString::fromLatin1(downloadHash) }
+        });
 
     return QJsonObject{
         { Keys::request,               jsonRequest                                        },
         { Keys::response,              jsonResponse                                       },
         { Keys::requestDate,           date.toUTC().toString(Constants::exportDateFormat) },
         { Keys::requestElaspedTime,    static_cast<qint32>(elapsedTime)                   },
+        { Keys::requestTimings,        timingsToJson(timings)                             },
+        { Keys::requestThroughput,     static_cast<double>(throughput)                    },
         { Keys::responseDisplayFormat, displayFormat                                      },
         { Keys::exportVersion,         Constants::applicationVersion                      }
     };
@@ -102,31 +151,56 @@ void Request::fromJson(const QJsonObject & json)
         from18Request(json, *this);
 }
 
+Request::Headers Request::requestHeaders() const
+{
+    Headers headers;
+    const auto headerNameList = rawHeaderList();
+    headers.reserve(headerNameList.size());
+    for (const auto & headerName : headerNameList)
+        headers.append(qMakePair(headerName, rawHeader(headerName)));
+    return headers;
+}
+
+void Request::setRequestHeaders(const Headers & headers)
+{
+    for (const auto & p : headers)
+        setRawHeader(p.first, p.second);
+}
+
 bool Request::isNull() const
 {
     return method.isEmpty() ||
            url().isEmpty();
 }
 
+QDataStream & operator<<(QDataStream & out, const RequestTimings & timings)
+{
+    out << timings.queued << timings.resolved << timings.encrypted << timings.sent;
+    out << timings.firstByte << timings.lastByte << timings.decoding;
+    return out;
+}
+
+QDataStream & operator>>(QDataStream & in, RequestTimings & timings)
+{
+    in >> timings.queued >> timings.resolved >> timings.encrypted >> timings.sent;
+    in >> timings.firstByte >> timings.lastByte >> timings.decoding;
+    return in;
+}
+
 QDataStream & operator<<(QDataStream & out, const Request & request)
 {
     out << request.url();
     out << request.method;
-
-    Request::Headers headers;
-    headers.reserve(request.rawHeaderList().size());
-    for (const auto & header : request.rawHeaderList())
-        headers.append(qMakePair(header, request.rawHeader(header)));
-    out << headers;
+    out << request.requestHeaders();
 
     out << request.hasContent;
     out << request.contentIsFilename;
-    out << request.content;
+    out << request.content.data();
 
     out << request.hasReceiveResponse;
     out << request.statusCode;
     out << request.reasonPhrase;
-    out << request.responseContent;
+    out << request.responseContent.data();
     out << request.responseHeaders;
 
     out << request.date;
@@ -147,17 +221,21 @@ QDataStream & operator>>(QDataStream & in, Request & request)
 
     Request::Headers headers;
     in >> headers;
-    for (const auto & p : headers)
-        request.setRawHeader(p.first, p.second);
+    request.setRequestHeaders(headers);
+
+    QByteArray content;
+    QByteArray responseContent;
 
     in >> request.hasContent;
     in >> request.contentIsFilename;
-    in >> request.content;
+    in >> content;
+    request.content = content;
 
     in >> request.hasReceiveResponse;
     in >> request.statusCode;
     in >> request.reasonPhrase;
-    in >> request.responseContent;
+    in >> responseContent;
+    request.responseContent = responseContent;
     in >> request.responseHeaders;
 
     in >> request.date;
@@ -16,41 +16,76 @@
 #include <QDataStream>
 #include <QJsonObject>
 
+// Project includes ------------------------------------------------------------
+#include "Body.hpp"
+
 // C++ standard library includes -----------------------------------------------
 #include <memory>
 
+// Time at which each phase of an exchange ended, in nanoseconds since the
+// request was submitted, or -1 when the phase was not observed
+struct RequestTimings
+{
+    qint64 queued    = -1; // Handed to the network access manager
+    qint64 resolved  = -1; // Host name resolved
+    qint64 encrypted = -1; // TLS handshake done, HTTPS only
+    qint64 sent      = -1; // Request body fully sent, only when there is one
+    qint64 firstByte = -1; // Response headers received
+    qint64 lastByte  = -1;
+
+    // Time spent decoding the body, along its download, or -1 when it was not
+    // encoded
+    qint64 decoding  = -1;
+
+    bool isEmpty() const { return lastByte < 0; }
+};
+
 struct Request : public QNetworkRequest
 {
     using Headers = QList<QPair<QByteArray, QByteArray>>;
 
-    QByteArray method;
+    quint64        id;
+
+    QByteArray     method;
+
+    bool           hasContent;
+    bool           contentIsFilename;
+    Body           content;
 
-    bool       hasContent;
-    bool       contentIsFilename;
-    QByteArray content;
+    bool           hasReceiveResponse;
+    quint32        statusCode;
+    QString        reasonPhrase;
+    Body           responseContent;
+    Headers        responseHeaders;
 
-    bool       hasReceiveResponse;
-    quint32    statusCode;
-    QString    reasonPhrase;
-    QByteArray responseContent;
-    Headers    responseHeaders;
+    QDateTime      date;
+    quint32        elapsedTime;
+    RequestTimings timings;
+    qint64         throughput;    // Average download rate, in bytes per second
+    qint64         wireSize;      // Response body size before its decoding
 
-    QDateTime  date;
-    quint32    elapsedTime;
+    // Set when the response body was written to a file instead of being kept
+    QString        downloadPath;
+    qint64         downloadSize;
+    QByteArray     downloadHash;  // SHA-256 of the file, in hexadecimal
 
-    qint32     displayFormat;
+    qint32         displayFormat;
 
     QJsonObject toJson() const;
     void fromJson(const QJsonObject & json);
 
+    Headers requestHeaders() const;
+    void setRequestHeaders(const Headers & headers);
+
     bool isNull() const;
+    bool isDownload() const { return !downloadPath.isEmpty(); }
 };
 
 using RequestPtr = std::shared_ptr<Request>;
 
+QDataStream & operator<<(QDataStream & out, const RequestTimings & timings);
+QDataStream & operator>>(QDataStream & in, RequestTimings & timings);
 QDataStream & operator<<(QDataStream & out, const Request & request);
 QDataStream & operator>>(QDataStream & in, Request & request);
 QDataStream & operator<<(QDataStream & out, const RequestPtr & request);
 QDataStream & operator>>(QDataStream & in, RequestPtr & request);
-
-Q_DECLARE_METATYPE(Request *);
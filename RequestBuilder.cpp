@@ -9,6 +9,10 @@
 
 #include "RequestBuilder.hpp"
 
+// Project includes ------------------------------------------------------------
+#include "RequestTimer.hpp"
+#include "ContentDecoder.hpp"
+
 // Qt includes -----------------------------------------------------------------
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
@@ -35,7 +39,8 @@ RequestBuilder::RequestBuilder(QWidget * parent) :
     QWidget(parent),
     _networkManager(new QNetworkAccessManager(this)),
     _currentRequest(nullptr),
-    _urlCompletionModel(new QStringListModel())
+    _urlCompletionModel(new QStringListModel()),
+    _contentNegotiation(false)
 {
     _ui.setupUi(this);
 
@@ -87,6 +92,16 @@ RequestBuilder::RequestBuilder(QWidget * parent) :
                      [this]{ _submitRequest(_ui.pbPut->text()); });
     QObject::connect(_ui.pbSubmit, &QPushButton::clicked, [this]
     { _submitRequest(_ui.cbMethod->currentText()); });
+    QObject::connect(_ui.pbDownload, &QPushButton::clicked, [this]
+    {
+        static auto directoryPath = QDir::homePath();
+        const auto filename = QFileDialog::getSaveFileName(this, "Download response to file",
+                                                           directoryPath);
+        if (filename.isEmpty())
+            return ;
+        directoryPath = QFileInfo(filename).absoluteFilePath();
+        _submitRequest(_ui.cbMethod->currentText(), filename);
+    });
 
     // Header view add button
     QObject::connect(_ui.leNameHeaders, &QLineEdit::textChanged, [this](const QString & text)
@@ -197,12 +212,12 @@ void RequestBuilder::displayRequest(RequestPtr request)
         if (request->contentIsFilename)
         {
             _ui.rbFile->setChecked(true);
-            _ui.leFilePath->setText(request->content);
+            _ui.leFilePath->setText(request->content.data());
         }
         else
         {
             _ui.rbContent->setChecked(true);
-            _ui.pteContent->setPlainText(request->content);
+            _ui.pteContent->setPlainText(request->content.data());
         }
     }
 
@@ -278,9 +293,10 @@ bool RequestBuilder::_filterLeContentTypeEvent(QEvent * event)
     return QObject::eventFilter(_ui.leContentType, event);
 }
 
-void RequestBuilder::_submitRequest(QString method)
+void RequestBuilder::_submitRequest(QString method, const QString & downloadPath)
 {
     _currentRequest = std::make_shared<Request>();
+    _currentRequest->downloadPath = downloadPath;
     _ui.cbMethod->setCurrentText(method);
 
     method.remove('&');
@@ -343,6 +359,11 @@ void RequestBuilder::_submitRequest(QString method)
                              _ui.tableHeaders->item(i, 1)->text().toUtf8());
     request.setHeader(QNetworkRequest::ContentTypeHeader, _ui.leContentType->text());
 
+    // Once set explicitly, the network access manager leaves the body encoded
+    // so it is decoded while received and its size on the wire is known
+    if (_contentNegotiation && !request.hasRawHeader("Accept-Encoding"))
+        request.setRawHeader("Accept-Encoding", ContentDecoder::acceptEncoding());
+
     _currentRequest->swap(request);
     _currentRequest->method = method.toLatin1();
     _currentRequest->date = QDateTime::currentDateTime();
@@ -353,7 +374,9 @@ void RequestBuilder::_submitRequest(QString method)
     _urlCompletionModel->setStringList(QStringList::fromSet(currentCompletionList));
 
     auto internalDevice = device.release();
+    auto timer = new RequestTimer(_currentRequest);
     auto reply = _networkManager->sendCustomRequest(*_currentRequest, method.toUtf8(), internalDevice);
+    timer->attach(reply);
     if (internalDevice != nullptr)
         QObject::connect(reply, &QNetworkReply::finished, internalDevice, &QObject::deleteLater);
 
@@ -40,6 +40,9 @@ public:
 
     void setRequestForCompletion(const QVector<RequestPtr> & requests);
 
+    // Offers the encodings the responses can be decoded from
+    void setContentNegotiationEnabled(bool value) { _contentNegotiation = value; }
+
 public slots:
     void displayRequest(RequestPtr request);
 
@@ -47,7 +50,7 @@ protected:
     bool eventFilter(QObject * watched, QEvent * event) override;
 
 private:
-    void _submitRequest(QString method);
+    void _submitRequest(QString method, const QString & downloadPath = {});
     void _urlChanged(const QString & rawUrl);
     void _parameterItemChanged(QTableWidgetItem * item);
     void _requestContentChanged();
@@ -78,6 +81,7 @@ private:
 
     RequestPtr              _currentRequest;
     QStringListModel *      _urlCompletionModel;
+    bool                    _contentNegotiation;
 
     QMap<QObject *, EventFilter> _eventFilters;
 };
@@ -0,0 +1,144 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "RequestExport.hpp"
+
+// Project includes ------------------------------------------------------------
+#include "Constants.hpp"
+
+namespace
+{
+constexpr const quint32 exportMagic = 0x58515248; // "HRQX"
+
+constexpr const quint8 requestMarker = 1;
+constexpr const quint8 endMarker     = 0;
+
+void setupStream(QDataStream & stream)
+{
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setVersion(QDataStream::Qt_5_6);
+}
+
+// The fields recorded since the first version follow the request, whose
+// layout is shared with the legacy history file
+void writeDetails(QDataStream & out, const Request & request)
+{
+    out << request.timings << request.throughput << request.wireSize;
+    out << request.downloadPath << request.downloadSize << request.downloadHash;
+}
+
+void readDetails(QDataStream & in, Request & request, quint32 version)
+{
+    request.timings    = RequestTimings();
+    request.throughput = 0;
+    request.wireSize   = request.responseContent.size();
+    if (version < 2)
+        return ;
+
+    in >> request.timings >> request.throughput >> request.wireSize;
+    in >> request.downloadPath >> request.downloadSize >> request.downloadHash;
+}
+} // !namespace
+
+RequestExporter::RequestExporter(QIODevice * device) :
+    _out(device),
+    _headerWritten(false)
+{
+    setupStream(_out);
+}
+
+bool RequestExporter::write(const Request & request)
+{
+    // The bodies are written as QByteArrays, a larger one cannot be exported
+    if (!request.content.fitsInArray() || !request.responseContent.fitsInArray())
+    {
+        qWarning("The request to '%s' has a body too large to be exported, skipping it", qPrintable(request.url().toString()));
+        return true;
+    }
+
+    if (!_headerWritten)
+    {
+        _out << exportMagic << Constants::binaryExportVersion;
+        _headerWritten = true;
+    }
+
+    // Stored bodies are read from their memory mapping while being written so
+    // only one of them is in memory at a time
+    _out << requestMarker << request;
+    writeDetails(_out, request);
+    return _out.status() == QDataStream::Ok;
+}
+
+bool RequestExporter::finish()
+{
+    if (!_headerWritten)
+    {
+        _out << exportMagic << Constants::binaryExportVersion;
+        _headerWritten = true;
+    }
+
+    _out << endMarker;
+    return _out.status() == QDataStream::Ok;
+}
+
+RequestImporter::RequestImporter(QIODevice * device) :
+    _in(device),
+    _version(0),
+    _valid(false),
+    _atEnd(true)
+{
+    setupStream(_in);
+
+    quint32 magic = 0;
+    _in >> magic >> _version;
+    _valid = _in.status() == QDataStream::Ok &&
+             magic == exportMagic &&
+             _version >= 1 && _version <= Constants::binaryExportVersion;
+    _atEnd = !_valid;
+}
+
+RequestPtr RequestImporter::read()
+{
+    if (_atEnd)
+        return nullptr;
+
+    quint8 marker = endMarker;
+    _in >> marker;
+    if (_in.status() != QDataStream::Ok || marker != requestMarker)
+    {
+        _atEnd = true;
+        return nullptr;
+    }
+
+    auto request = std::make_shared<Request>();
+    _in >> *request;
+    readDetails(_in, *request, _version);
+    if (_in.status() != QDataStream::Ok)
+    {
+        qWarning("The request export is corrupted, ignoring the rest of it");
+        _atEnd = true;
+        return nullptr;
+    }
+
+    return request;
+}
+
+bool RequestImporter::canRead(QIODevice * device)
+{
+    const auto header = device->peek(sizeof(exportMagic));
+    if (header.size() != sizeof(exportMagic))
+        return false;
+
+    QDataStream in(header);
+    setupStream(in);
+
+    quint32 magic = 0;
+    in >> magic;
+    return magic == exportMagic;
+}
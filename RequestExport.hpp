@@ -0,0 +1,59 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QIODevice>
+#include <QDataStream>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+
+// Binary export format of the requests.
+//
+// Unlike the JSON export the bodies and headers are written as they are, and
+// the requests are written and read one by one: the size of the export is not
+// limited by the available memory and the time it takes only depends on the
+// size of the data. The format is identified by a magic number followed by
+// Constants::binaryExportVersion, then each request is preceded by a marker
+// and the export ends with an end marker.
+class RequestExporter
+{
+public:
+    explicit RequestExporter(QIODevice * device);
+
+    bool write(const Request & request);
+    bool finish();
+
+private:
+    QDataStream _out;
+    bool        _headerWritten;
+};
+
+class RequestImporter
+{
+public:
+    explicit RequestImporter(QIODevice * device);
+
+    bool isValid() const { return _valid; }
+    bool atEnd() const   { return _atEnd; }
+
+    // Returns nullptr at the end of the export or if it is corrupted
+    RequestPtr read();
+
+public:
+    static bool canRead(QIODevice * device);
+
+private:
+    QDataStream _in;
+    quint32     _version;
+    bool        _valid;
+    bool        _atEnd;
+};
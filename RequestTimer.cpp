@@ -0,0 +1,85 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "RequestTimer.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QNetworkReply>
+
+RequestTimer::RequestTimer(const RequestPtr & request, QObject * parent) :
+    QObject(parent),
+    _request(request),
+    _received(0),
+    _lookupId(-1)
+{
+    _timer.start();
+
+    const auto host = request->url().host();
+    if (!host.isEmpty())
+        _lookupId = QHostInfo::lookupHost(host, this, &RequestTimer::_onLookedUp);
+}
+
+RequestTimer::~RequestTimer()
+{
+    if (_lookupId != -1)
+        QHostInfo::abortHostLookup(_lookupId);
+}
+
+void RequestTimer::attach(QNetworkReply * reply)
+{
+    _timings.queued = _timer.nsecsElapsed();
+    setParent(reply);
+
+    QObject::connect(reply, &QNetworkReply::encrypted, this, [this]
+    { _timings.encrypted = _timer.nsecsElapsed(); });
+
+    QObject::connect(reply, &QNetworkReply::uploadProgress, this, [this](qint64 bytesSent, qint64 bytesTotal)
+    {
+        if (bytesTotal > 0 && bytesSent == bytesTotal)
+            _timings.sent = _timer.nsecsElapsed();
+    });
+
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, this, [this]
+    {
+        if (_timings.firstByte < 0)
+            _timings.firstByte = _timer.nsecsElapsed();
+    });
+
+    QObject::connect(reply, &QNetworkReply::downloadProgress, this, [this](qint64 bytesReceived, qint64)
+    { _received = bytesReceived; });
+
+    QObject::connect(reply, &QNetworkReply::finished, this, &RequestTimer::_onFinished);
+}
+
+void RequestTimer::_onLookedUp(const QHostInfo & info)
+{
+    _lookupId = -1;
+    if (info.error() == QHostInfo::NoError && _timings.lastByte < 0)
+        _timings.resolved = _timer.nsecsElapsed();
+}
+
+void RequestTimer::_onFinished()
+{
+    _timings.lastByte = _timer.nsecsElapsed();
+
+    // A lookup outlasting the exchange was not the one the manager waited for
+    if (_lookupId != -1)
+    {
+        QHostInfo::abortHostLookup(_lookupId);
+        _lookupId = -1;
+    }
+
+    _request->timings     = _timings;
+    _request->elapsedTime = static_cast<quint32>(_timings.lastByte / 1000000);
+
+    // The rate of the body transfer alone, the wait for the server is excluded
+    const auto downloadTime = _timings.lastByte - _timings.firstByte;
+    _request->throughput = _timings.firstByte >= 0 && downloadTime > 0 ?
+                           static_cast<qint64>(_received * 1e9 / downloadTime) : 0;
+}
@@ -0,0 +1,59 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHostInfo>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+
+// Qt forward declarations -----------------------------------------------------
+QT_BEGIN_NAMESPACE
+class QNetworkReply;
+QT_END_NAMESPACE
+
+// Records the timings of the phases of a request.
+//
+// The timer is started right before the request is handed to the network
+// access manager and follows its reply, whose signals mark the end of the TLS
+// handshake, of the upload and of the headers reception. The timings, the
+// elapsed time and the average download rate are written into the request
+// when the reply is finished, before the other handlers of the reply are
+// called as long as it is attached first.
+//
+// The network access manager does not report the resolution of the host name,
+// it is timed by a lookup made in parallel, which the lookup of the manager
+// shares the result of through the host information cache. The TCP connection
+// is not reported either, it falls into the phase preceding the first one
+// observed after it.
+class RequestTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RequestTimer(const RequestPtr & request, QObject * parent = nullptr);
+    ~RequestTimer() override;
+
+    void attach(QNetworkReply * reply);
+
+private:
+    void _onLookedUp(const QHostInfo & info);
+    void _onFinished();
+
+private:
+    RequestPtr     _request;
+    QElapsedTimer  _timer;
+    RequestTimings _timings;
+    qint64         _received;
+    int            _lookupId;
+};
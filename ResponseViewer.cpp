@@ -11,20 +11,180 @@
 
 // Project includes ------------------------------------------------------------
 #include "QJsonModel.hpp"
+#include "BodyBuffer.hpp"
+#include "ContentDecoder.hpp"
+#include "HistoryModel.hpp"
+#include "Constants.hpp"
 
 // Qt includes -----------------------------------------------------------------
 #include <QNetworkReply>
-#include <QElapsedTimer>
-#include <QJsonDocument>
 #include <QFontMetrics>
 #include <QResizeEvent>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QSignalBlocker>
+
+namespace
+{
+constexpr const auto hexFormat       = 4;
+constexpr const auto binaryProbeSize = 4096;
+
+// Body of a reply being received, shared by the handlers of the reply
+class Reception
+{
+public:
+    explicit Reception(qint64 spillThreshold) :
+        _buffer(spillThreshold),
+        _hash(QCryptographicHash::Sha256),
+        _fileSize(0),
+        _wireSize(0),
+        _decodeTime(0)
+    {}
+
+    BodyBuffer & buffer()                  { return _buffer; }
+    qint64 wireSize() const                { return _wireSize; }
+    qint64 fileSize() const                { return _fileSize; }
+    QByteArray fileHash() const            { return _file == nullptr ? QByteArray() : _hash.result().toHex(); }
+    bool isDecoded() const                 { return _decoder != nullptr; }
+    qint64 decodeTime() const              { return _decodeTime; }
+    QString errorString() const
+    { return _errorString.isEmpty() ? _buffer.errorString() : _errorString; }
+
+    // The body is then written to the file instead of the buffer, it only
+    // replaces the file once fully received
+    bool setFile(const QString & filename)
+    {
+        _file.reset(new QSaveFile(filename));
+        if (_file->open(QIODevice::WriteOnly))
+            return true;
+
+        _errorString = _file->errorString();
+        return false;
+    }
+
+    // Drops what was written to the file, which is left as it was, and keeps
+    // the rest of the body in the buffer
+    void discardFile()
+    {
+        if (_file == nullptr)
+            return ;
+
+        _file->cancelWriting();
+        _file.reset();
+        _fileSize = 0;
+    }
+
+    // Only the first headers are used, the body cannot change its encoding
+    void setHeaders(QNetworkReply * reply)
+    {
+        if (_wireSize > 0 || _decoder != nullptr)
+            return ;
+
+        // An error page must not replace the destination of a download
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400)
+            discardFile();
+
+        // The network access manager decodes the body itself, but keeps its
+        // Content-Encoding header, unless the request set Accept-Encoding
+        if (reply->request().hasRawHeader("Accept-Encoding"))
+            _decoder = ContentDecoder::create(reply->rawHeader("Content-Encoding"));
+        if (_decoder == nullptr)
+            _buffer.reserve(reply->header(QNetworkRequest::ContentLengthHeader).toLongLong());
+    }
+
+    bool receive(const QByteArray & data, bool finish)
+    {
+        if (!_errorString.isEmpty())
+            return false;
+
+        _wireSize += data.size();
+        if (_decoder == nullptr)
+            return _write(data, finish);
+
+        QElapsedTimer timer;
+        timer.start();
+        QByteArray decoded;
+        const auto decodedAll = _decoder->decode(data, decoded) && (!finish || _decoder->finish(decoded));
+        _decodeTime += timer.nsecsElapsed();
+        if (!decodedAll)
+        {
+            _errorString = _decoder->errorString();
+            return false;
+        }
+
+        return _write(decoded, finish);
+    }
+
+private:
+    bool _write(const QByteArray & data, bool finish)
+    {
+        if (_file == nullptr)
+            return _buffer.append(data);
+
+        _hash.addData(data);
+        _fileSize += data.size();
+        if (_file->write(data) != data.size() || (finish && !_file->commit()))
+        {
+            _errorString = _file->errorString();
+            _file->cancelWriting();
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    BodyBuffer                      _buffer;
+    std::unique_ptr<QSaveFile>      _file;
+    QCryptographicHash              _hash;
+    qint64                          _fileSize;
+    std::unique_ptr<ContentDecoder> _decoder;
+    qint64                          _wireSize;
+    qint64                          _decodeTime;
+    QString                         _errorString;
+};
+
+// Text bodies do not hold null bytes, whatever their encoding but UTF-16
+bool looksBinary(const Body & body)
+{
+    return body.read(0, binaryProbeSize).contains('\0');
+}
+
+// Downloaded bodies are not kept, only where they were written
+QString downloadText(const Request & request)
+{
+    const auto path = QDir::toNativeSeparators(request.downloadPath);
+    if (!request.hasReceiveResponse)
+        return QString("Downloading to %1...").arg(path);
+    if (request.downloadHash.isEmpty())
+        return QString("Download to %1 failed, the file was left unchanged").arg(path);
+
+    return QString("Downloaded to %1\n%2, SHA-256 %3").arg(path)
+                                                       .arg(HistoryModel::formatSize(request.downloadSize))
+                                                       .arg(request.downloadHash.constData());
+}
+
+QByteArray contentEncoding(const Request::Headers & headers)
+{
+    for (const auto & header : headers)
+        if (header.first.toLower() == "content-encoding")
+            return header.second;
+    return {};
+}
+} // !namespace
 
 ResponseViewer::ResponseViewer(QWidget * parent) :
     QTabWidget(parent),
     _jsonModel(new QJsonModel),
-    _currentRequest(nullptr)
+    _treeItems(0),
+    _formats(Constants::formatCacheSize),
+    _formatPending(FormatCache::Format::Indented),
+    _currentRequest(nullptr),
+    _spillThreshold(Constants::spillThreshold)
 {
     _ui.setupUi(this);
     _ui.treeResponse->setModel(_jsonModel);
@@ -41,8 +201,11 @@ ResponseViewer::ResponseViewer(QWidget * parent) :
         if (_currentRequest == nullptr)
             return ;
 
+        const auto changed = _currentRequest->displayFormat != format;
         _currentRequest->displayFormat = format;
         _displayResponseData(_currentRequest->responseContent);
+        if (changed)
+            emit displayFormatChanged(_currentRequest);
     });
 
     QObject::connect(_ui.stackedWidget, &QStackedWidget::currentChanged, [this](int index)
@@ -52,11 +215,18 @@ ResponseViewer::ResponseViewer(QWidget * parent) :
         _ui.pbExpand->setVisible(visible);
         if (visible)
         {
-            _ui.treeResponse->expandAll();
+            // Expanding a large tree would lay out all of its items at once
+            if (_treeItems <= Constants::treeExpandMaxItems)
+                _ui.treeResponse->expandAll();
+            else
+                _ui.treeResponse->expandToDepth(0);
             _ui.treeResponse->resizeColumnToContents(0);
         }
     });
 
+    QObject::connect(&_formatter, &QFutureWatcher<FormatCache::Entry>::finished,
+                     this, &ResponseViewer::_onFormatted);
+
     QObject::connect(_ui.pbCollapse, &QPushButton::clicked,
                      _ui.treeResponse, &QTreeView::collapseAll);
     QObject::connect(_ui.pbExpand, &QPushButton::clicked,
@@ -78,6 +248,11 @@ ResponseViewer::ResponseViewer(QWidget * parent) :
     _ui.lUrl->installEventFilter(this);
 }
 
+ResponseViewer::~ResponseViewer()
+{
+    _cancelFormatting();
+}
+
 void ResponseViewer::setRequest(RequestPtr request)
 {
     _currentRequest = request;
@@ -86,24 +261,51 @@ void ResponseViewer::setRequest(RequestPtr request)
 
 void ResponseViewer::handleReply(QNetworkReply * reply)
 {
-    QElapsedTimer elapsedTimer;
-    elapsedTimer.start();
+    // The body is consumed and decoded as it arrives, so neither Qt nor the
+    // buffer holds more than the spill threshold in memory
+    const auto reception = std::make_shared<Reception>(_spillThreshold);
+    reply->setReadBufferSize(Constants::receiveChunkSize);
+
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, [reply, reception]
+    { reception->setHeaders(reply); });
 
-    QObject::connect(reply, &QNetworkReply::finished, [reply, elapsedTimer, this]
+    QObject::connect(reply, &QNetworkReply::readyRead, [reply, reception]
     {
+        if (!reception->receive(reply->readAll(), false))
+            reply->abort();
+    });
+
+    QObject::connect(reply, &QNetworkReply::finished, [reply, reception, this]
+    {
+        // A canceled or interrupted download is not committed
+        if (reply->error() != QNetworkReply::NoError ||
+            reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400)
+            reception->discardFile();
+
+        const auto complete = reception->receive(reply->readAll(), true) && reception->errorString().isEmpty();
+
         _currentRequest->hasReceiveResponse = true;
         _currentRequest->statusCode         = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toUInt();
         _currentRequest->reasonPhrase       = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString();
-        _currentRequest->responseContent    = reply->readAll();
+        _currentRequest->responseContent    = reception->buffer().take();
         _currentRequest->responseHeaders    = reply->rawHeaderPairs();
-        _currentRequest->elapsedTime        = static_cast<quint32>(elapsedTimer.elapsed());
-
-        if (reply->error() != QNetworkReply::NoError && reply->error() < QNetworkReply::ProxyConnectionRefusedError)
+        _currentRequest->wireSize           = reception->wireSize();
+        _currentRequest->timings.decoding   = reception->isDecoded() ? reception->decodeTime() : -1;
+        _currentRequest->downloadSize       = complete ? reception->fileSize() : 0;
+        _currentRequest->downloadHash       = complete ? reception->fileHash() : QByteArray();
+
+        if (!complete)
+            _currentRequest->reasonPhrase = QString("Body not fully received: %1").arg(reception->errorString());
+        else if (reply->error() != QNetworkReply::NoError && reply->error() < QNetworkReply::ProxyConnectionRefusedError)
             _currentRequest->reasonPhrase = reply->errorString();
 
         _updateGui();
         emit replyReceived();
     });
+
+    // Deferred so the caller has connected to the reply before it finishes
+    if (_currentRequest->isDownload() && !reception->setFile(_currentRequest->downloadPath))
+        QMetaObject::invokeMethod(reply, "abort", Qt::QueuedConnection);
 }
 
 bool ResponseViewer::saveResponseContentToFile(const QString & filename,
@@ -118,29 +320,57 @@ bool ResponseViewer::saveResponseContentToFile(const QString & filename,
         return false;
     }
 
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    // Saving a download onto its own file has nothing to do
+    const auto isDownload = !_currentRequest->downloadHash.isEmpty();
+    if (isDownload && QFileInfo(filename) == QFileInfo(_currentRequest->downloadPath))
+        return true;
+
+    // Written into a temporary file which only replaces the destination once
+    // complete, an existing file is left untouched if anything fails
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
     {
         errString = file.errorString();
         return false;
     }
 
-    const auto content = _currentRequest->responseContent;
-    switch (_ui.cbFormat->currentIndex())
+    // The body of a completed download is only in its file
+    const auto & content = _currentRequest->responseContent;
+    const auto   format  = _ui.cbFormat->currentIndex();
+    if (isDownload)
     {
-        case 1: // Indented
-        case 2: // Tree
+        QFile source(_currentRequest->downloadPath);
+        if (!source.open(QIODevice::ReadOnly))
         {
-            const auto jsonDocument = QJsonDocument::fromJson(content);
-            if (jsonDocument.isNull())
-                file.write(content);
-            else
-                file.write(jsonDocument.toJson(QJsonDocument::Indented));
+            errString = source.errorString();
+            return false;
+        }
+
+        while (!source.atEnd())
+        {
+            const auto chunk = source.read(BodyReader::pageSize);
+            if (chunk.isEmpty() || file.write(chunk) != chunk.size())
+            {
+                errString = chunk.isEmpty() ? source.errorString() : file.errorString();
+                return false;
+            }
         }
-            break;
-        default:
-            file.write(content);
-            break;
+    }
+    // Indented or tree, a body larger than a QByteArray is never formatted
+    else if ((format == 1 || format == 2) && content.fitsInArray())
+        file.write(_formats.indented(content));
+    else
+    {
+        // Copied by pages, the body may not fit in a QByteArray
+        for (qint64 offset = 0; offset < content.size(); offset += BodyReader::pageSize)
+            file.write(content.read(offset, BodyReader::pageSize));
+    }
+
+    // A failed write is reported by the commit
+    if (!file.commit())
+    {
+        errString = file.errorString();
+        return false;
     }
 
     return true;
@@ -179,48 +409,68 @@ void ResponseViewer::_updateGui()
     _ui.lStatus->setText(QString("%1 %2").arg(_currentRequest->statusCode)
                                           .arg(_currentRequest->reasonPhrase));
 
+    // The format is chosen once the body is received: a binary body would be
+    // garbled and slow to lay out as text, so it is never displayed as such
+    if (_currentRequest->displayFormat == -1 && _currentRequest->hasReceiveResponse)
+        _currentRequest->displayFormat = looksBinary(_currentRequest->responseContent) ?
+                                         hexFormat : _ui.cbFormat->currentIndex();
+    if (_currentRequest->displayFormat != -1)
+    {
+        // The body is only displayed below, in its format
+        const QSignalBlocker blocker(_ui.cbFormat);
+        _ui.cbFormat->setCurrentIndex(_currentRequest->displayFormat);
+    }
+
     _displayResponseData(_currentRequest->responseContent);
+    _ui.waterfall->setTimings(_currentRequest->timings, contentEncoding(_currentRequest->responseHeaders));
 
     _ui.tableHeaders->clearContents();
     _ui.tableHeaders->setRowCount(0);
     for (const auto & p : _currentRequest->responseHeaders)
         _addEntryToTable(_ui.tableHeaders, p.first, p.second);
     _ui.tableHeaders->resizeColumnToContents(0);
-
-    if (_currentRequest->displayFormat == -1)
-        _currentRequest->displayFormat = _ui.cbFormat->currentIndex();
-    else
-        _ui.cbFormat->setCurrentIndex(_currentRequest->displayFormat);
 }
 
-void ResponseViewer::_displayResponseData(const QByteArray & data)
+void ResponseViewer::_displayResponseData(const Body & body)
 {
+    _cancelFormatting();
     _ui.stackedWidget->setCurrentIndex(0);
-    if (data.isEmpty())
+    _ui.ltvResponse->clear();
+    _ui.hexResponse->clear();
+    _ui.pteResponse->setPlaceholderText({});
+    if (body.isEmpty())
+    {
         _ui.pteResponse->clear();
+        if (_currentRequest != nullptr && _currentRequest->isDownload())
+            _ui.pteResponse->setPlaceholderText(downloadText(*_currentRequest));
+    }
     else
     {
         switch (_ui.cbFormat->currentIndex())
         {
             case 0: // Raw
-                _ui.pteResponse->setPlainText(data);
+                _displayText(body);
                 break;
             case 1: // Indented
-            {
-                const auto json = QJsonDocument::fromJson(data);
-                _ui.pteResponse->setPlainText(json.isNull() ? data : json.toJson(QJsonDocument::Indented));
-            }
+                _displayFormatted(body, FormatCache::Format::Indented);
                 break;
             case 2: // Tree
-                if (!_jsonModel->loadJson(data))
-                    _ui.pteResponse->setPlainText(data);
-                else
-                    _ui.stackedWidget->setCurrentIndex(1);
+                _displayFormatted(body, FormatCache::Format::Tree);
                 break;
             case 3: // HTML
-                _ui.teHtmlResponse->setHtml(data);
+                // The whole document would be laid out at once, as a text
+                if (body.size() > Constants::largeTextSize)
+                {
+                    _displayText(body);
+                    break;
+                }
+                _ui.teHtmlResponse->setHtml(body.data());
                 _ui.stackedWidget->setCurrentIndex(2);
                 break;
+            case 4: // Hex
+                _ui.hexResponse->setData(body);
+                _ui.stackedWidget->setCurrentIndex(4);
+                break;
             default:
                 break;
 
@@ -228,6 +478,90 @@ void ResponseViewer::_displayResponseData(const QByteArray & data)
     }
 }
 
+void ResponseViewer::_displayText(const Body & text)
+{
+    // Large texts would take seconds to be laid out by the text edit
+    if (text.size() <= Constants::largeTextSize)
+    {
+        _ui.pteResponse->setPlainText(text.data());
+        return ;
+    }
+
+    _ui.pteResponse->clear();
+    _ui.ltvResponse->setData(text);
+    _ui.stackedWidget->setCurrentIndex(3);
+}
+
+void ResponseViewer::_displayFormatted(const Body & body, FormatCache::Format format)
+{
+    // A body larger than a QByteArray cannot be parsed, it is shown as it is
+    if (!body.fitsInArray())
+    {
+        _displayText(body);
+        return ;
+    }
+
+    // The GUI thread only looks the cache up when the key is known without
+    // reading the body, which may have to be decompressed and hashed
+    FormatCache::Formats formats;
+    if (FormatCache::hasKey(body))
+        formats = _formats.find(FormatCache::key(body));
+    if (formats.has(format))
+    {
+        _displayFormats(formats, format, body);
+        return ;
+    }
+
+    // Parsing a large body takes seconds, the placeholder is shown meanwhile
+    // and the worker result is dropped if another body is displayed first. The
+    // body is captured so its file stays mapped while the worker reads it.
+    _ui.pteResponse->clear();
+    _ui.pteResponse->setPlaceholderText("Formatting the response...");
+
+    const auto canceled = std::make_shared<std::atomic<bool>>(false);
+    _formatCanceled = canceled;
+    _formatPending  = format;
+    _formatter.setFuture(QtConcurrent::run([formats, body, format, canceled]
+    {
+        const auto data = body.uncachedData();
+        return qMakePair(FormatCache::key(body, data), FormatCache::build(formats, data, format, canceled.get()));
+    }));
+}
+
+void ResponseViewer::_displayFormats(const FormatCache::Formats & formats, FormatCache::Format format,
+                                     const Body & body)
+{
+    if (!formats.isJson())
+        _displayText(body);
+    else if (format == FormatCache::Format::Indented)
+        _displayText(formats.indented);
+    else
+    {
+        _treeItems = formats.treeItems;
+        _jsonModel->setRoot(formats.tree);
+        _ui.stackedWidget->setCurrentIndex(1);
+    }
+}
+
+void ResponseViewer::_onFormatted()
+{
+    if (_formatter.future().isCanceled() || _formatCanceled == nullptr || *_formatCanceled)
+        return ;
+
+    _formatCanceled.reset();
+    const auto entry = _formatter.result();
+    _formats.insert(entry.first, entry.second);
+    _ui.pteResponse->setPlaceholderText({});
+    _displayFormats(entry.second, _formatPending, _currentRequest->responseContent);
+}
+
+void ResponseViewer::_cancelFormatting()
+{
+    if (_formatCanceled != nullptr)
+        *_formatCanceled = true;
+    _formatCanceled.reset();
+}
+
 bool ResponseViewer::_addEntryToTable(QTableWidget * table,
                                       const QString & name,
                                       const QString & value)
@@ -11,10 +11,16 @@
 
 // Qt includes -----------------------------------------------------------------
 #include <QTabWidget>
+#include <QFutureWatcher>
 
 // Project includes ------------------------------------------------------------
 #include "ui_ResponseViewer.h"
 #include "Request.hpp"
+#include "FormatCache.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <atomic>
+#include <memory>
 
 // Qt forward declarations -----------------------------------------------------
 QT_BEGIN_NAMESPACE
@@ -33,9 +39,13 @@ class ResponseViewer : public QTabWidget
 
 public:
     explicit ResponseViewer(QWidget * parent = nullptr);
+    ~ResponseViewer() override;
 
     RequestPtr request() const { return _currentRequest; }
 
+    void setSpillThreshold(qint64 value) { _spillThreshold = value; }
+    void setFormatCacheSize(qint64 size) { _formats.setMaxCost(size); }
+
 public slots:
     void setRequest(RequestPtr request);
     void handleReply(QNetworkReply * reply);
@@ -48,7 +58,13 @@ protected:
 
 private:
     void _updateGui();
-    void _displayResponseData(const QByteArray & data);
+    void _displayResponseData(const Body & body);
+    void _displayText(const Body & text);
+    void _displayFormatted(const Body & body, FormatCache::Format format);
+    void _displayFormats(const FormatCache::Formats & formats, FormatCache::Format format,
+                         const Body & body);
+    void _onFormatted();
+    void _cancelFormatting();
 
 private:
     static bool _addEntryToTable(QTableWidget * table,
@@ -58,10 +74,18 @@ private:
 
 signals:
     void replyReceived();
+    void displayFormatChanged(RequestPtr request);
 
 private:
-    Ui::ResponseViewer _ui;
-    QJsonModel       * _jsonModel;
+    Ui::ResponseViewer  _ui;
+    QJsonModel        * _jsonModel;
+    int                 _treeItems;
+    mutable FormatCache _formats;
+
+    QFutureWatcher<FormatCache::Entry> _formatter;
+    std::shared_ptr<std::atomic<bool>> _formatCanceled;
+    FormatCache::Format                _formatPending;
 
-    RequestPtr         _currentRequest;
+    RequestPtr          _currentRequest;
+    qint64              _spillThreshold;
 };
@@ -0,0 +1,208 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "SearchIndex.hpp"
+
+// Project includes ------------------------------------------------------------
+#include "Constants.hpp"
+
+// C++ standard library includes -----------------------------------------------
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+constexpr const auto    binaryProbeSize = 1024;
+constexpr const quint64 positionsMask   = 0xff;
+
+quint32 trigram(const char * p)
+{
+    return (static_cast<quint32>(static_cast<uchar>(p[0])) << 16) |
+           (static_cast<quint32>(static_cast<uchar>(p[1])) << 8)  |
+            static_cast<quint32>(static_cast<uchar>(p[2]));
+}
+
+void appendTrigrams(const QByteArray & text, SearchIndex::Entry & trigrams)
+{
+    for (int i = 0; i + 3 <= text.size(); ++i)
+        trigrams.push_back(trigram(text.constData() + i) << 8 | 1u << (i % 8));
+}
+
+// The positions of the identical trigrams are merged into a single mask
+void mergeTrigrams(SearchIndex::Entry & trigrams)
+{
+    std::sort(trigrams.begin(), trigrams.end());
+    auto size = 0;
+    for (int i = 0; i < trigrams.size(); ++i)
+        if (size > 0 && trigrams.at(size - 1) >> 8 == trigrams.at(i) >> 8)
+            trigrams[size - 1] |= trigrams.at(i) & 0xff;
+        else
+            trigrams[size++] = trigrams.at(i);
+    trigrams.resize(size);
+}
+
+// Positions, modulo 8, at which a query may start for its trigram at the
+// offset to be at one of the positions of the mask
+quint8 startMask(quint64 mask, int offset)
+{
+    const auto shift = offset % 8;
+    mask &= 0xff;
+    return static_cast<quint8>((mask >> shift) | (mask << (8 - shift)));
+}
+
+bool isBinary(const QByteArray & data)
+{
+    return data.left(binaryProbeSize).contains('\0');
+}
+} // !namespace
+
+void SearchIndex::insert(quint64 id, const Entry & entry)
+{
+    remove(id);
+
+    // Requests are mostly indexed in the order of their identifier
+    for (const auto & value : entry)
+    {
+        auto & postings = _postings[value >> 8];
+        const auto posting = id << 8 | (value & 0xff);
+        if (postings.isEmpty() || postings.last() < posting)
+            postings.push_back(posting);
+        else
+            postings.insert(std::lower_bound(postings.begin(), postings.end(), posting), posting);
+    }
+
+    _trigrams.insert(id, entry);
+}
+
+void SearchIndex::remove(quint64 id)
+{
+    const auto itr = _trigrams.find(id);
+    if (itr == _trigrams.end())
+        return ;
+
+    for (const auto & value : itr.value())
+    {
+        auto postings = _postings.find(value >> 8);
+        if (postings == _postings.end())
+            continue;
+
+        auto & ids = postings.value();
+        const auto position = std::lower_bound(ids.begin(), ids.end(), id << 8);
+        if (position != ids.end() && *position >> 8 == id)
+            ids.erase(position);
+        if (ids.isEmpty())
+            _postings.erase(postings);
+    }
+
+    _trigrams.erase(itr);
+}
+
+void SearchIndex::clear()
+{
+    _postings.clear();
+    _trigrams.clear();
+}
+
+QVector<quint64> SearchIndex::find(const QByteArray & query) const
+{
+    if (!canLookUp(query))
+        return {};
+
+    QVector<QPair<int, const QVector<quint64> *>> lists;
+    for (int offset = 0; offset + 3 <= query.size(); ++offset)
+    {
+        const auto itr = _postings.constFind(trigram(query.constData() + offset));
+        if (itr == _postings.constEnd())
+            return {};
+        lists.push_back(qMakePair(offset, &itr.value()));
+    }
+
+    // The lists are intersected from the shortest one, along the positions
+    // at which the query may start in each request
+    std::sort(lists.begin(), lists.end(), [](const QPair<int, const QVector<quint64> *> & v1,
+                                             const QPair<int, const QVector<quint64> *> & v2)
+    { return v1.second->size() < v2.second->size(); });
+
+    QVector<quint64> starts;
+    starts.reserve(lists.first().second->size());
+    for (const auto & posting : *lists.first().second)
+        starts.push_back((posting & ~positionsMask) | startMask(posting, lists.first().first));
+
+    for (int i = 1; i < lists.size() && !starts.isEmpty(); ++i)
+    {
+        const auto   offset   = lists.at(i).first;
+        const auto & postings = *lists.at(i).second;
+        auto         posting  = postings.begin();
+        auto         size     = 0;
+        for (const auto & start : starts)
+        {
+            posting = std::lower_bound(posting, postings.end(), start & ~positionsMask);
+            if (posting == postings.end())
+                break;
+            if (*posting >> 8 != start >> 8)
+                continue;
+
+            const auto mask = (start & positionsMask) & startMask(*posting, offset);
+            if (mask != 0)
+                starts[size++] = (start & ~positionsMask) | mask;
+        }
+        starts.resize(size);
+    }
+
+    QVector<quint64> ids;
+    ids.reserve(starts.size());
+    for (const auto & start : starts)
+        ids.push_back(start >> 8);
+    return ids;
+}
+
+bool SearchIndex::matches(quint64 id, const QByteArray & query) const
+{
+    const auto itr = _trigrams.constFind(id);
+    if (!canLookUp(query) || itr == _trigrams.constEnd())
+        return false;
+
+    // Same rules as find(), on the trigrams of the request
+    const auto & trigrams = itr.value();
+    quint32 starts = 0xff;
+    for (int offset = 0; offset + 3 <= query.size() && starts != 0; ++offset)
+    {
+        const auto value    = trigram(query.constData() + offset);
+        const auto position = std::lower_bound(trigrams.begin(), trigrams.end(), value << 8);
+        if (position == trigrams.end() || *position >> 8 != value)
+            return false;
+        starts &= startMask(*position, offset);
+    }
+
+    return starts != 0;
+}
+
+QByteArray SearchIndex::normalize(const QString & query)
+{
+    return query.toUtf8().toLower();
+}
+
+SearchIndex::Entry SearchIndex::entry(const Request & request)
+{
+    Entry trigrams;
+    appendTrigrams(request.url().toString().toUtf8().toLower(), trigrams);
+
+    for (const auto & header : request.requestHeaders())
+        appendTrigrams((header.first + ": " + header.second).toLower(), trigrams);
+    for (const auto & header : request.responseHeaders)
+        appendTrigrams((header.first + ": " + header.second).toLower(), trigrams);
+
+    // Only the beginning of the body is indexed, the rest is not even read
+    const auto content = request.responseContent.read(0, Constants::searchMaxBodySize);
+    if (!content.isEmpty() && !isBinary(content))
+        appendTrigrams(content.toLower(), trigrams);
+
+    mergeTrigrams(trigrams);
+    return trigrams;
+}
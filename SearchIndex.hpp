@@ -0,0 +1,66 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QHash>
+#include <QVector>
+#include <QByteArrayList>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+
+// Trigram index of the text of the requests.
+//
+// The searchable text of a request is its URL, its request and response
+// headers and its response body. Each distinct trigram of that text, ignoring
+// the case, references the requests containing it along with the positions it
+// appears at, modulo 8. The requests containing a query are found by
+// intersecting the lists of its trigrams and keeping those where the trigrams
+// may follow each other as in the query, without reading any body. A request
+// holding all the trigrams of a query at compatible positions but not the
+// query itself is a false positive, which is accepted.
+//
+// Binary bodies are not indexed, and only the beginning of large ones. The
+// identifiers of the requests must fit in 56 bits.
+class SearchIndex
+{
+public:
+    // Sorted trigrams of a request, each shifted by 8 bits above the mask of
+    // its positions
+    using Entry   = QVector<quint32>;
+    using Entries = QHash<quint64, Entry>;
+
+public:
+    void insert(const Request & request) { insert(request.id, entry(request)); }
+    void insert(quint64 id, const Entry & entry);
+    void remove(quint64 id);
+    void clear();
+    bool contains(quint64 id) const      { return _trigrams.contains(id); }
+
+    // Sorted identifiers of the requests containing the query, queries
+    // shorter than a trigram cannot be looked up
+    QVector<quint64> find(const QByteArray & query) const;
+    bool matches(quint64 id, const QByteArray & query) const;
+
+public:
+    static bool canLookUp(const QByteArray & query) { return query.size() >= 3; }
+    static QByteArray normalize(const QString & query);
+
+    // Reads the response body, so can be called by a worker on a copy of the
+    // request
+    static Entry entry(const Request & request);
+
+private:
+    // Posting of a request: its identifier shifted by 8 bits above the mask
+    // of the positions of the trigram
+    QHash<quint32, QVector<quint64>> _postings;
+    Entries                          _trigrams;
+};
@@ -0,0 +1,53 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QHash>
+#include <QVector>
+
+// Interned values, each distinct value is stored once and referenced by a
+// small identifier. Values are never removed, except all at once.
+template <typename T>
+class StringPool
+{
+public:
+    quint32 intern(const T & value)
+    {
+        const auto itr = _ids.constFind(value);
+        if (itr != _ids.constEnd())
+            return itr.value();
+
+        const auto id = static_cast<quint32>(_values.size());
+        _values.push_back(value);
+        _ids.insert(value, id);
+        return id;
+    }
+
+    // Returns -1 when the value has never been interned
+    qint64 find(const T & value) const
+    {
+        const auto itr = _ids.constFind(value);
+        return itr == _ids.constEnd() ? -1 : static_cast<qint64>(itr.value());
+    }
+
+    const T & value(quint32 id) const { return _values.at(static_cast<int>(id)); }
+    int size() const                  { return _values.size(); }
+
+    void clear()
+    {
+        _values.clear();
+        _ids.clear();
+    }
+
+private:
+    QVector<T>        _values;
+    QHash<T, quint32> _ids;
+};
@@ -0,0 +1,69 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "TransferRate.hpp"
+
+namespace
+{
+constexpr const qint64 rateWindow     = 1000 * 1000 * 1000;
+constexpr const qint64 sampleInterval =   50 * 1000 * 1000;
+} // !namespace
+
+TransferRate::TransferRate() :
+    _bytes(0),
+    _time(0)
+{
+    _timer.start();
+}
+
+void TransferRate::update(qint64 bytes)
+{
+    _time  = _timer.nsecsElapsed();
+    _bytes = bytes;
+
+    Sample sample;
+    sample.time  = _time;
+    sample.bytes = _bytes;
+    if (_samples.isEmpty())
+        _origin = sample;
+    else if (_time - _samples.last().time < sampleInterval)
+        return ;
+
+    _samples.push_back(sample);
+    while (_samples.size() > 2 && _time - _samples.at(1).time >= rateWindow)
+        _samples.removeFirst();
+}
+
+qint64 TransferRate::current() const
+{
+    if (_samples.isEmpty())
+        return 0;
+
+    const auto & first = _samples.first();
+    return _rate(_bytes - first.bytes, _time - first.time);
+}
+
+qint64 TransferRate::average() const
+{
+    return _rate(_bytes - _origin.bytes, _time - _origin.time);
+}
+
+qint64 TransferRate::remaining(qint64 total) const
+{
+    const auto rate = current();
+    if (total <= 0 || rate <= 0)
+        return -1;
+
+    return qMax<qint64>(0, total - _bytes) * 1000 / rate;
+}
+
+qint64 TransferRate::_rate(qint64 bytes, qint64 duration)
+{
+    return duration > 0 ? static_cast<qint64>(bytes * 1e9 / duration) : 0;
+}
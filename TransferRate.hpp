@@ -0,0 +1,51 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QElapsedTimer>
+#include <QVector>
+
+// Throughput of a transfer, sampled from its progress notifications.
+//
+// The current rate is measured over about the last second so it follows the
+// changes of speed, the average one since the first notification. The samples
+// are taken at a bounded frequency whatever the number of notifications.
+class TransferRate
+{
+public:
+    TransferRate();
+
+    void update(qint64 bytes);
+
+    qint64 bytes() const { return _bytes; }
+    qint64 current() const;
+    qint64 average() const;
+
+    // Milliseconds at the current rate, -1 when unknown
+    qint64 remaining(qint64 total) const;
+
+private:
+    struct Sample
+    {
+        qint64 time  = 0;   // Nanoseconds
+        qint64 bytes = 0;
+    };
+
+private:
+    static qint64 _rate(qint64 bytes, qint64 duration);
+
+private:
+    QElapsedTimer   _timer;
+    Sample          _origin;
+    QVector<Sample> _samples;     // Oldest first, the first one opens the window
+    qint64          _bytes;
+    qint64          _time;
+};
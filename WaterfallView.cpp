@@ -0,0 +1,122 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#include "WaterfallView.hpp"
+
+// Qt includes -----------------------------------------------------------------
+#include <QPainter>
+
+namespace
+{
+constexpr const auto rowSpacing = 6;
+constexpr const auto margin     = 8;
+
+QString formatDuration(qint64 nanoseconds)
+{
+    return QString("%1 ms").arg(nanoseconds / 1000000.0, 0, 'f', 3);
+}
+} // !namespace
+
+WaterfallView::WaterfallView(QWidget * parent) :
+    QWidget(parent)
+{}
+
+void WaterfallView::setTimings(const RequestTimings & timings, const QByteArray & encoding)
+{
+    _phases = phases(timings, encoding);
+    setMinimumHeight((_phases.size() + 1) * (fontMetrics().height() + rowSpacing));
+    update();
+}
+
+QVector<WaterfallView::Phase> WaterfallView::phases(const RequestTimings & timings, const QByteArray & encoding)
+{
+    QVector<Phase> phases;
+    if (timings.isEmpty())
+        return phases;
+
+    // The lookup is timed in parallel with the manager so it can end after the
+    // phases following it, which are then shown as empty
+    const QVector<QPair<QString, qint64>> ends{
+        {"Queued",        timings.queued},
+        {"DNS",           timings.resolved},
+        {"Connect & TLS", timings.encrypted},
+        {"Send",          timings.sent},
+        {"Wait",          timings.firstByte},
+        {"Download",      timings.lastByte}
+    };
+
+    qint64 start = 0;
+    for (auto i = 0; i < ends.size(); ++i)
+    {
+        const auto end = ends.at(i).second;
+        if (end < 0)
+            continue;
+
+        Phase phase;
+        phase.name  = ends.at(i).first;
+        phase.start = start;
+        phase.end   = qBound(start, end, timings.lastByte);
+        phases.push_back(phase);
+        start = phase.end;
+    }
+
+    if (timings.decoding >= 0)
+    {
+        Phase phase;
+        phase.name  = QString("Decoding %1").arg(QString::fromLatin1(encoding));
+        phase.start = qMax<qint64>(0, timings.lastByte - timings.decoding);
+        phase.end   = timings.lastByte;
+        phases.push_back(phase);
+    }
+
+    return phases;
+}
+
+void WaterfallView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    if (_phases.isEmpty())
+    {
+        painter.drawText(rect(), Qt::AlignCenter, "No timings recorded");
+        return ;
+    }
+
+    const auto metrics    = fontMetrics();
+    const auto rowHeight  = metrics.height() + rowSpacing;
+    const auto total      = _phases.last().end;
+
+    auto labelWidth    = 0;
+    auto durationWidth = metrics.width(formatDuration(total));
+    for (const auto & phase : _phases)
+    {
+        labelWidth    = qMax(labelWidth, metrics.width(phase.name));
+        durationWidth = qMax(durationWidth, metrics.width(formatDuration(phase.end - phase.start)));
+    }
+
+    const auto chartLeft  = labelWidth + 2 * margin;
+    const auto chartWidth = qMax(1, width() - chartLeft - durationWidth - 2 * margin);
+    const auto scale      = total > 0 ? static_cast<double>(chartWidth) / total : 0.0;
+
+    for (auto i = 0; i < _phases.size(); ++i)
+    {
+        const auto & phase = _phases.at(i);
+        const QRect row(0, i * rowHeight, width(), rowHeight);
+        const QRectF bar(chartLeft + phase.start * scale, row.top() + rowSpacing / 2,
+                         qMax(1.0, (phase.end - phase.start) * scale), metrics.height());
+
+        painter.drawText(row.adjusted(margin, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter, phase.name);
+        painter.fillRect(bar, palette().highlight());
+        painter.drawText(row.adjusted(0, 0, -margin, 0), Qt::AlignRight | Qt::AlignVCenter,
+                         formatDuration(phase.end - phase.start));
+    }
+
+    const QRect footer(0, _phases.size() * rowHeight, width(), rowHeight);
+    painter.drawText(footer.adjusted(0, 0, -margin, 0), Qt::AlignRight | Qt::AlignVCenter,
+                     QString("Total: %1").arg(formatDuration(total)));
+}
@@ -0,0 +1,49 @@
+/*
+** Copyright 2018 ViVoka
+**
+** Made by Vincent Leroy
+** Mail <vl@vivoka.com>
+**
+** vivoka.com
+*/
+
+#pragma once
+
+// Qt includes -----------------------------------------------------------------
+#include <QWidget>
+#include <QVector>
+
+// Project includes ------------------------------------------------------------
+#include "Request.hpp"
+
+// Waterfall of the phases of a request, one bar per phase on a common time
+// scale. A phase which was not observed is merged into the following one.
+//
+// The decoding of the body is spread along its download, it is drawn as a
+// single bar ending with the download.
+class WaterfallView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    struct Phase
+    {
+        QString name;
+        qint64  start = 0;
+        qint64  end   = 0;
+    };
+
+public:
+    explicit WaterfallView(QWidget * parent = nullptr);
+
+    void setTimings(const RequestTimings & timings, const QByteArray & encoding = {});
+
+public:
+    static QVector<Phase> phases(const RequestTimings & timings, const QByteArray & encoding = {});
+
+protected:
+    void paintEvent(QPaintEvent * event) override;
+
+private:
+    QVector<Phase> _phases;
+};